@@ -1,3 +1,4 @@
+#pragma once
 #include <string>
 
 enum ActionType { MOVE = 0, INC = 1, BOMB = 2, WAIT = 3, MSG = 4 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "00_perf.hpp"
 #include <iostream>
 #include <vector>
 #include <map>
@@ -37,6 +38,9 @@ class GameState {
 public:
     static const int MAX_FACTORIES = 15;
     static const int INF = 1e9;
+
+    using FactoryList = perf::FixedVector<const Factory*, MAX_FACTORIES>;
+
     int factoryCount;
     int linkCount;
 
@@ -160,22 +164,22 @@ public:
         return distances[from][to];
     }
 
-    std::vector<const Factory*> getMyFactories() const {
-        std::vector<const Factory*> res;
+    FactoryList getMyFactories() const {
+        FactoryList res;
         for (const auto& f : factories)
             if (f.owner == ME) res.push_back(&f);
         return res;
     }
 
-    std::vector<const Factory*> getNeutralFactories() const {
-        std::vector<const Factory*> res;
+    FactoryList getNeutralFactories() const {
+        FactoryList res;
         for (const auto& f : factories)
             if (f.owner == NEUTRAL) res.push_back(&f);
         return res;
     }
 
-    std::vector<const Factory*> getEnemyFactories() const {
-        std::vector<const Factory*> res;
+    FactoryList getEnemyFactories() const {
+        FactoryList res;
         for (const auto& f : factories)
             if (f.owner == ENEMY) res.push_back(&f);
         return res;
@@ -1,4 +1,5 @@
 #pragma once
+#include "00_perf.hpp"
 #include "02_game_state.hpp"
 #include "01_utils.hpp"
 #include <vector>
@@ -15,6 +16,7 @@ public:
 class GreedyAI : public AI {
 public:
     std::vector<Action> getActions(const GameState& state) override {
+        PERF_ZONE("GreedyAI::getActions");
         std::vector<Action> actions;
         std::map<int, int> incomingEnemyCyborgs;
         std::set<int> factoriesNeedingHelp;
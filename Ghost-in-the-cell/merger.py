@@ -3,13 +3,15 @@ from pathlib import Path
 
 PROJECT_ROOT = Path(".")
 OUTPUT_FILE = Path("combined.cpp")
+# Header-only code shared by every C++ bot; its 00_ prefix puts it first
+SHARED_ROOT = Path("../Utils")
 
 def extract_prefix(filename):
     match = re.match(r"(\d+)_", filename.name)
     return int(match.group(1)) if match else 999
 
 def collect_files():
-    all_hpps = list(Path(".").rglob("*.hpp"))
+    all_hpps = list(Path(".").rglob("*.hpp")) + list(SHARED_ROOT.glob("*.hpp"))
     all_cpps = list(Path(".").rglob("*.cpp"))
 
     hpps = sorted([f for f in all_hpps if f.name != OUTPUT_FILE.name], key=extract_prefix)
@@ -2,6 +2,7 @@
 //#define MODE_LOCAL
 #define MODE_LIVE
 
+#include "00_perf.hpp"
 #include "02_game_state.hpp"
 #include "03_ai.hpp"
 #include "01_utils.hpp"
@@ -12,6 +13,8 @@
 #ifdef MODE_LOCAL
 #endif
 
+const double TURN_MS = 50;
+
 int main() {
 #ifdef MODE_LIVE
     GameState state;
@@ -19,6 +22,9 @@ int main() {
     GreedyAI ai;
 
     while (true) {
+        // The turn starts when its input starts arriving, so parsing counts
+        std::cin.peek();
+        perf::DeadlineTimer timer(TURN_MS);
         state.updateFromTurnInput();
         auto actions = ai.getActions(state);
 
@@ -27,6 +33,9 @@ int main() {
             if (i + 1 < actions.size()) std::cout << ";";
         }
         std::cout << std::endl;
+        std::cerr << "turn " << timer.elapsedMs() << " / " << TURN_MS << " ms" << std::endl;
+        perf::profiler().report();
+        perf::profiler().reset();
     }
 
 #else
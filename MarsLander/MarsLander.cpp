@@ -1,24 +1,80 @@
+#pragma GCC optimize("O3,inline")
+#pragma GCC target("avx2")
+
 #include <iostream>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
-#include <ctime>
 #include <iomanip>
 #include <chrono>
+#include <cstdio>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <queue>
+#include <filesystem>
+#include <immintrin.h>
+
+#include "../Utils/00_perf.hpp"
 
 using namespace std;
 using namespace std::chrono;
 
 # define M_PI 3.14159265358979323846
-constexpr int CHROMOSOME_SIZE = 100;
-constexpr int POPULATION_SIZE = 50;
-constexpr double MUTATION_RATE = 0.02;
 constexpr double GRAVITY = 3.711;
 constexpr int MAX_SURFACE_POINTS = 30;
-constexpr int ELITS = 10;
-constexpr int TOURNAMENT_SIZE = 5;
+constexpr double SPEED_PENALTY = 20;   // Fitness per m/s over the safe landing speeds
+constexpr double ROTATE_PENALTY = 10;  // Fitness per degree of tilt at touchdown
+constexpr double CRASH_PENALTY = 10000; // Fitness lost by crashing off the pad or leaving the map
+constexpr int MAP_WIDTH = 7000;
+constexpr int MAP_HEIGHT = 3000;
+constexpr int TERRAIN_BUCKET = 100;    // Width of the x-columns used to look up surface segments
+constexpr int TERRAIN_BUCKETS = MAP_WIDTH / TERRAIN_BUCKET;
+constexpr int DISTANCE_CELL = 50;     // Spacing of the distance-to-pad grid
+constexpr int DISTANCE_COLUMNS = MAP_WIDTH / DISTANCE_CELL + 1;
+constexpr int DISTANCE_ROWS = MAP_HEIGHT / DISTANCE_CELL + 1;
+constexpr int IN_FLIGHT = -1;          // Touchdown result of a trajectory that never hit anything
+constexpr int OFF_MAP = -2;            // Touchdown result of a trajectory that left the map
+constexpr int SIM_LANES = 4;           // Chromosomes advanced together by simulateBatch (one AVX2 register of doubles)
+constexpr double SIMD_TOLERANCE = 0.0; // Allowed |batch - scalar| fitness gap under VERIFY_SIMD
+constexpr int CHECKPOINT_INTERVAL = 10; // Genes between stored trajectory states
+constexpr int MAX_HOLD_FRAMES = 10;     // Longest a held command lasts in the hold encoding
+constexpr double REFINE_RATE = 0.1;     // Chance per mutation to split the hold at touchdown
+constexpr int MIGRANTS = 2;            // Elites an island sends to its neighbour per migration
+constexpr int MIGRATION_INTERVAL = 50; // Generations between migrations
+constexpr int MAX_TURNS = 500;         // Local episodes give up after this many turns
+
+constexpr double FIRST_TURN_MS = 1000;   // Response limit on the first turn
+constexpr double TURN_MS = 100;          // Response limit on every later turn
+constexpr double RESPONSE_MARGIN_MS = 2; // Kept for reading input and writing the answer
+constexpr const char* TELEMETRY_PATH = "telemetry.bin"; // Written by live -DTELEMETRY builds
+
+enum Phase { PHASE_SELECTION, PHASE_CROSSOVER, PHASE_MUTATION, PHASE_SIMULATION, PHASES };
+const char* const PHASE_NAMES[PHASES] = {"selection", "crossover", "mutation", "simulation"};
 
-double landingStartX, landingEndX, landingY;
+// The search parameters as one compile-time bundle. Chromosome,
+// GeneticPopulation and everything built on them are instantiated per
+// bundle, so each preset gets its own fully specialised code. With Holds > 0
+// the plan is evolved as that many held commands instead of one gene per
+// frame; see Chromosome::decode.
+template <int ChromosomeSize, int PopulationSize, int Elits, int TournamentSize, int MutationPerMille, int Holds = 0>
+struct GeneticConfig {
+    static constexpr int HOLDS = Holds;
+    static constexpr int CHROMOSOME_SIZE = ChromosomeSize;
+    static constexpr int POPULATION_SIZE = PopulationSize;
+    static constexpr int ELITS = Elits;
+    static constexpr int TOURNAMENT_SIZE = TournamentSize;
+    static constexpr double MUTATION_RATE = MutationPerMille / 1000.0;
+    static constexpr int CHECKPOINTS = CHROMOSOME_SIZE / CHECKPOINT_INTERVAL;
+
+    static_assert(CHROMOSOME_SIZE % CHECKPOINT_INTERVAL == 0, "plans are simulated in whole checkpoint segments");
+    static_assert(ELITS < POPULATION_SIZE, "some chromosomes have to be bred");
+    static_assert(HOLDS == 0 || HOLDS * MAX_HOLD_FRAMES >= CHROMOSOME_SIZE, "holds have to be able to cover the plan");
+};
 
 class Gene {
 public:
@@ -29,252 +85,1931 @@ public:
     Gene(int r, int p) : rotate(r), power(p) {}
 };
 
+// A command of the hold encoding: steer towards an absolute rotate and
+// power, then keep them, for 'frames' turns
+struct Hold {
+    int rotate;
+    int power;
+    int frames;
+};
+
 struct GameState {
     double x, y;          // Position
     double hSpeed, vSpeed; // Horizontal and vertical speed
     int fuel;             // Remaining fuel
     int rotate;           // Current rotation angle
     int power;            // Current thrust power
+
+    bool read(istream& in) {
+        return (bool)(in >> x >> y >> hSpeed >> vSpeed >> fuel >> rotate >> power);
+    }
+};
+
+// The surface polyline plus a per-column index of the segments over each
+// TERRAIN_BUCKET-wide column. Built once per game; a simulated step then
+// checks a couple of column peaks and only tests segments near the ground.
+struct Terrain {
+    pair<int, int> surface[MAX_SURFACE_POINTS];
+    int surfaceN;
+    int landingSegment; // Segment i joins surface[i] and surface[i + 1]
+    double landingStartX, landingEndX, landingY;
+
+    double peak[TERRAIN_BUCKETS]; // Highest surface point over each column
+    double highest;               // Highest surface point overall
+    int bucketSegments[TERRAIN_BUCKETS][MAX_SURFACE_POINTS];
+    int bucketSize[TERRAIN_BUCKETS];
+
+    // Length of the shortest path through free space from each grid node to
+    // the landing pad; nodes under the surface continue the column above
+    float padDistance[DISTANCE_ROWS][DISTANCE_COLUMNS];
+
+    Terrain() : surfaceN(0), landingSegment(-1), landingStartX(0), landingEndX(0), landingY(0) {}
+
+    bool read(istream& in) {
+        in >> surfaceN;
+        for (int i = 0; i < surfaceN; ++i) {
+            in >> surface[i].first >> surface[i].second;
+        }
+        build();
+        return (bool)in;
+    }
+
+    void build() {
+        for (int i = 0; i + 1 < surfaceN; ++i) {
+            if (surface[i].second == surface[i + 1].second) {
+                landingSegment = i;
+                landingStartX = min(surface[i].first, surface[i + 1].first);
+                landingEndX = max(surface[i].first, surface[i + 1].first);
+                landingY = surface[i].second;
+            }
+        }
+
+        highest = -1;
+        for (int b = 0; b < TERRAIN_BUCKETS; ++b) {
+            peak[b] = -1;
+            bucketSize[b] = 0;
+        }
+        for (int i = 0; i + 1 < surfaceN; ++i) {
+            int from = bucketOf(min(surface[i].first, surface[i + 1].first));
+            int to = bucketOf(max(surface[i].first, surface[i + 1].first));
+            for (int b = from; b <= to; ++b) {
+                bucketSegments[b][bucketSize[b]++] = i;
+                peak[b] = max(peak[b], (double)max(surface[i].second, surface[i + 1].second));
+            }
+            highest = max(highest, (double)max(surface[i].second, surface[i + 1].second));
+        }
+
+        buildPadDistance();
+    }
+
+    // Dijkstra over the grid nodes above the surface, seeded from the nodes
+    // right over the pad. Moves between neighbours that cross the surface
+    // are not allowed, so paths go around ridges and out of caves.
+    void buildPadDistance() {
+        const float UNREACHED = 1e9f;
+        bool free[DISTANCE_ROWS][DISTANCE_COLUMNS];
+        for (int j = 0; j < DISTANCE_ROWS; ++j) {
+            for (int i = 0; i < DISTANCE_COLUMNS; ++i) {
+                free[j][i] = j * DISTANCE_CELL > heightAt(i * DISTANCE_CELL);
+                padDistance[j][i] = UNREACHED;
+            }
+        }
+
+        typedef pair<float, int> Entry; // Distance, j * DISTANCE_COLUMNS + i
+        priority_queue<Entry, vector<Entry>, greater<Entry>> open;
+        for (int i = 0; i < DISTANCE_COLUMNS; ++i) {
+            double x = i * DISTANCE_CELL;
+            if (x < landingStartX || x > landingEndX) {
+                continue;
+            }
+            for (int j = 0; j < DISTANCE_ROWS && j * DISTANCE_CELL <= landingY + DISTANCE_CELL; ++j) {
+                if (free[j][i]) {
+                    padDistance[j][i] = j * DISTANCE_CELL - landingY;
+                    open.push(Entry(padDistance[j][i], j * DISTANCE_COLUMNS + i));
+                }
+            }
+        }
+
+        while (!open.empty()) {
+            Entry entry = open.top();
+            open.pop();
+            int j = entry.second / DISTANCE_COLUMNS, i = entry.second % DISTANCE_COLUMNS;
+            if (entry.first > padDistance[j][i]) {
+                continue;
+            }
+            for (int dj = -1; dj <= 1; ++dj) {
+                for (int di = -1; di <= 1; ++di) {
+                    int nj = j + dj, ni = i + di;
+                    if ((!dj && !di) || nj < 0 || nj >= DISTANCE_ROWS || ni < 0 || ni >= DISTANCE_COLUMNS || !free[nj][ni]) {
+                        continue;
+                    }
+                    float next = entry.first + (dj && di ? (float)M_SQRT2 : 1.0f) * DISTANCE_CELL;
+                    if (next < padDistance[nj][ni] &&
+                        touchdown(i * DISTANCE_CELL, j * DISTANCE_CELL, ni * DISTANCE_CELL, nj * DISTANCE_CELL) < 0) {
+                        padDistance[nj][ni] = next;
+                        open.push(Entry(next, nj * DISTANCE_COLUMNS + ni));
+                    }
+                }
+            }
+        }
+
+        // Below the surface, keep climbing to the first free node so a crash
+        // site still scores by where it is
+        for (int i = 0; i < DISTANCE_COLUMNS; ++i) {
+            for (int j = DISTANCE_ROWS - 2; j >= 0; --j) {
+                if (!free[j][i]) {
+                    padDistance[j][i] = padDistance[j + 1][i] + DISTANCE_CELL;
+                }
+            }
+        }
+    }
+
+    // Surface height under x, for x inside the map
+    double heightAt(double x) const {
+        for (int i = 0; i + 1 < surfaceN; ++i) {
+            double x0 = surface[i].first, x1 = surface[i + 1].first;
+            if (x >= x0 && x <= x1 && x1 > x0) {
+                return surface[i].second + (surface[i + 1].second - surface[i].second) * (x - x0) / (x1 - x0);
+            }
+        }
+        return surfaceN > 0 ? surface[surfaceN - 1].second : 0;
+    }
+
+    // Bilinear lookup of the path distance to the pad at (x, y)
+    double distanceToPad(double x, double y) const {
+        double gx = max(0.0, min((double)MAP_WIDTH, x)) / DISTANCE_CELL;
+        double gy = max(0.0, min((double)MAP_HEIGHT, y)) / DISTANCE_CELL;
+        int i = min((int)gx, DISTANCE_COLUMNS - 2);
+        int j = min((int)gy, DISTANCE_ROWS - 2);
+        double fx = gx - i, fy = gy - j;
+        double bottom = padDistance[j][i] + fx * (padDistance[j][i + 1] - padDistance[j][i]);
+        double top = padDistance[j + 1][i] + fx * (padDistance[j + 1][i + 1] - padDistance[j + 1][i]);
+        return bottom + fy * (top - bottom);
+    }
+
+    static int bucketOf(double x) {
+        return max(0, min(TERRAIN_BUCKETS - 1, (int)x / TERRAIN_BUCKET));
+    }
+
+    static bool outside(double x, double y) {
+        return x < 0 || x >= MAP_WIDTH || y < 0 || y >= MAP_HEIGHT;
+    }
+
+    // Outcome of moving from (x0, y0) to (x1, y1): the index of the first
+    // surface segment crossed, OFF_MAP, or IN_FLIGHT when nothing was hit
+    int touchdown(double x0, double y0, double x1, double y1) const {
+        int from = bucketOf(min(x0, x1));
+        int to = bucketOf(max(x0, x1));
+        double highest = peak[from];
+        for (int b = from + 1; b <= to; ++b) {
+            highest = max(highest, peak[b]);
+        }
+        if (min(y0, y1) > highest) {
+            return outside(x1, y1) ? OFF_MAP : IN_FLIGHT;
+        }
+
+        for (int b = from; b <= to; ++b) {
+            for (int k = 0; k < bucketSize[b]; ++k) {
+                int i = bucketSegments[b][k];
+                if (crosses(x0, y0, x1, y1, surface[i].first, surface[i].second, surface[i + 1].first, surface[i + 1].second)) {
+                    return i;
+                }
+            }
+        }
+        return outside(x1, y1) ? OFF_MAP : IN_FLIGHT;
+    }
+
+    // Whether ending on 'state' after hitting 'touchdown' is a valid landing
+    bool landed(const GameState& state, int touchdown) const {
+        return touchdown == landingSegment &&
+               state.rotate == 0 && abs(state.hSpeed) <= 20 && abs(state.vSpeed) <= 40;
+    }
+
+    static bool crosses(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy) {
+        double d1 = (dx - cx) * (ay - cy) - (dy - cy) * (ax - cx);
+        double d2 = (dx - cx) * (by - cy) - (dy - cy) * (bx - cx);
+        double d3 = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+        double d4 = (bx - ax) * (dy - ay) - (by - ay) * (dx - ax);
+        return ((d1 > 0) != (d2 > 0) || d2 == 0) && ((d3 > 0) != (d4 > 0) || d3 == 0 || d4 == 0);
+    }
 };
 
+template <class Config>
 class Chromosome {
 public:
+    static constexpr int CHROMOSOME_SIZE = Config::CHROMOSOME_SIZE;
+    static constexpr int CHECKPOINTS = Config::CHECKPOINTS;
+    static constexpr int HOLDS = Config::HOLDS;
+    // Evolved ints: rotate and power of every gene, or rotate, power and
+    // frames of every hold
+    static constexpr int SLOTS = HOLDS ? 3 * HOLDS : 2 * CHROMOSOME_SIZE;
+
+    // Mutation draws are Bernoulli(MUTATION_RATE) over every rotate and power
+    // slot; the gap to the next mutated slot is geometric, so sample it directly.
+    static inline const double LOG_MUTATION_KEEP = log(1.0 - Config::MUTATION_RATE);
+
+    static int nextMutationGap(perf::Rng& rng) {
+        return (int)(log(1.0 - rng.nextDouble()) / LOG_MUTATION_KEEP);
+    }
+
+    // Per-frame rotate and power changes. With holds these are decoded from
+    // holds[] for the current root state and are what gets simulated.
     Gene genes[CHROMOSOME_SIZE];
+    Hold holds[HOLDS ? HOLDS : 1];
     double fitness;
 
-    Chromosome() : fitness(0) {}
+    // Incremental evaluation: checkpoints[k] is the state before gene
+    // k * CHECKPOINT_INTERVAL of the last simulation, valid while that gene is
+    // below both dirtyFrom (first gene changed since) and usedGenes (genes
+    // played before touchdown). Changes past usedGenes never affect fitness.
+    GameState checkpoints[CHECKPOINTS];
+    int usedGenes;
+    int dirtyFrom;
+
+    Chromosome() : fitness(0), usedGenes(CHROMOSOME_SIZE), dirtyFrom(0) {}
+
+    int* slots() { return HOLDS ? &holds[0].rotate : &genes[0].rotate; }
+    const int* slots() const { return HOLDS ? &holds[0].rotate : &genes[0].rotate; }
 
-    void initialize() {
-        for (int i = 0; i < CHROMOSOME_SIZE; ++i) {
-            genes[i] = Gene(rand() % 31 - 15, rand() % 3 - 1);
+    static int slotMin(int slot) {
+        if constexpr (HOLDS) {
+            const int MIN[3] = {-90, 0, 1};
+            return MIN[slot % 3];
         }
+        return (slot & 1) ? -1 : -15;
     }
 
-    void mutate() {
-        for (int i = 0; i < CHROMOSOME_SIZE; ++i) {
-            if ((double)rand() / RAND_MAX < MUTATION_RATE) {
-                genes[i].rotate = (rand() % 31 - 15);
+    static int slotMax(int slot) {
+        if constexpr (HOLDS) {
+            const int MAX[3] = {90, 4, MAX_HOLD_FRAMES};
+            return MAX[slot % 3];
+        }
+        return (slot & 1) ? 1 : 15;
+    }
+
+    void initialize(perf::Rng& rng) {
+        int* values = slots();
+        for (int slot = 0; slot < SLOTS; ++slot) {
+            values[slot] = rng.nextRange(slotMin(slot), slotMax(slot));
+        }
+        dirtyFrom = 0;
+    }
+
+    void mutate(perf::Rng& rng) {
+        if constexpr (HOLDS) {
+            int* values = slots();
+            for (int slot = nextMutationGap(rng); slot < SLOTS; slot += 1 + nextMutationGap(rng)) {
+                values[slot] = rng.nextRange(slotMin(slot), slotMax(slot));
             }
-            if ((double)rand() / RAND_MAX < MUTATION_RATE) {
-                genes[i].power = (rand() % 3 - 1);
+            if (rng.nextDouble() < REFINE_RATE) {
+                refine();
+            }
+            return;
+        }
+
+        // Slot 2 * i is genes[i].rotate, slot 2 * i + 1 is genes[i].power
+        for (int slot = nextMutationGap(rng); slot < 2 * CHROMOSOME_SIZE; slot += 1 + nextMutationGap(rng)) {
+            Gene& gene = genes[slot >> 1];
+            int& value = (slot & 1) ? gene.power : gene.rotate;
+            int mutated = (slot & 1) ? rng.nextRange(-1, 1) : rng.nextRange(-15, 15);
+            if (mutated != value) {
+                value = mutated;
+                dirtyFrom = min(dirtyFrom, slot >> 1);
             }
         }
     }
 
-    double calculateFitness(GameState state, const pair<int, int> surface[MAX_SURFACE_POINTS], int surfaceN) {
-        for (int i = 1; i < surfaceN; ++i) {
-            if (state.x >= surface[i - 1].first && state.x <= surface[i].first) {
-                double surfaceY = surface[i - 1].second + (surface[i].second - surface[i - 1].second) * (state.x - surface[i - 1].first) / (surface[i].first - surface[i - 1].first);
+    // Splits the hold that was active at touchdown in two, reusing the last
+    // hold when it only starts after touchdown and so never mattered. This
+    // gives the final approach finer control the closer the lander gets.
+    void refine() {
+        int start[HOLDS ? HOLDS : 1];
+        for (int k = 0, frame = 0; k < HOLDS; frame += holds[k++].frames) {
+            start[k] = frame;
+        }
+        int touchdown = usedGenes - 1;
+        if (start[HOLDS - 1] <= touchdown) {
+            return;
+        }
+        int k = HOLDS - 1;
+        while (k > 0 && start[k] > touchdown) {
+            --k;
+        }
+        if (holds[k].frames < 2) {
+            return;
+        }
+        move_backward(holds + k + 1, holds + HOLDS - 1, holds + HOLDS);
+        holds[k + 1] = holds[k];
+        holds[k].frames /= 2;
+        holds[k + 1].frames -= holds[k].frames;
+    }
 
-                if (state.y <= surfaceY) {
-                    if (i > 0 && surface[i].second == surface[i - 1].second && 
-                        state.x >= landingStartX && state.x <= landingEndX &&
-                        state.rotate == 0 && abs(state.hSpeed) <= 20 && abs(state.vSpeed) <= 40) {
-                        return 10000 - state.fuel;
-                    } else {
-                        return -10000;
-                    }
+    // Expands the holds into per-frame genes for a root with 'rotate' and
+    // 'power'. Each hold turns and throttles towards its target as fast as the
+    // rules allow and the last one lasts to the end of the plan. Only frames
+    // that came out different from before are marked dirty.
+    void decode(int rotate, int power) {
+        int frame = 0;
+        int changed = CHROMOSOME_SIZE;
+        for (int k = 0; k < HOLDS && frame < CHROMOSOME_SIZE; ++k) {
+            int end = k == HOLDS - 1 ? CHROMOSOME_SIZE : min(CHROMOSOME_SIZE, frame + holds[k].frames);
+            for (; frame < end; ++frame) {
+                Gene gene(max(-15, min(15, holds[k].rotate - rotate)), max(-1, min(1, holds[k].power - power)));
+                rotate += gene.rotate;
+                power += gene.power;
+                if (changed == CHROMOSOME_SIZE && (gene.rotate != genes[frame].rotate || gene.power != genes[frame].power)) {
+                    changed = frame;
                 }
-                break;
+                genes[frame] = gene;
+            }
+        }
+        dirtyFrom = min(dirtyFrom, changed);
+    }
+
+    // Drops the gene that has just been played and appends a random one;
+    // with holds, the first hold loses a frame instead
+    void shift(perf::Rng& rng) {
+        if constexpr (HOLDS) {
+            if (--holds[0].frames == 0) {
+                move(holds + 1, holds + HOLDS, holds);
+                Hold& last = holds[HOLDS - 1];
+                last.rotate = rng.nextRange(-90, 90);
+                last.power = rng.nextRange(0, 4);
+                last.frames = rng.nextRange(1, MAX_HOLD_FRAMES);
+            }
+        } else {
+            move(genes + 1, genes + CHROMOSOME_SIZE, genes);
+            genes[CHROMOSOME_SIZE - 1] = Gene(rng.nextRange(-15, 15), rng.nextRange(-1, 1));
+        }
+        dirtyFrom = 0;
+    }
+
+    // Takes over the evaluation of a parent whose first 'prefix' genes this
+    // chromosome shares, copying only the checkpoints that are still valid
+    void inheritFrom(const Chromosome& parent, int prefix) {
+        fitness = parent.fitness;
+        usedGenes = parent.usedGenes;
+        dirtyFrom = min(prefix, parent.dirtyFrom);
+        int valid = min(dirtyFrom, usedGenes - 1) / CHECKPOINT_INTERVAL + 1;
+        copy(parent.checkpoints, parent.checkpoints + valid, checkpoints);
+    }
+
+    // Landings rank by fuel left, then touchdowns on the pad by how far
+    // they were from a safe landing, then everything else by the path
+    // distance from where the plan ended to the pad, with crashes and exits
+    // ranked below plans still flying at the same distance
+    double calculateFitness(const GameState& state, int touchdown, const Terrain& terrain) const {
+        if (terrain.landed(state, touchdown)) {
+            return 10000 + state.fuel;
+        }
+        if (touchdown == terrain.landingSegment) {
+            double excess = max(0.0, abs(state.hSpeed) - 20) + max(0.0, abs(state.vSpeed) - 40);
+            return 5000 - SPEED_PENALTY * excess - ROTATE_PENALTY * abs(state.rotate);
+        }
+        double distance = terrain.distanceToPad(state.x, state.y);
+        return touchdown == IN_FLIGHT ? -distance : -distance - CRASH_PENALTY;
+    }
+};
+
+// Thrust for every reachable (rotate, power) pair, packed as (hAcc, vAcc,
+// power, 0) so one aligned load fetches a whole command. Filled once with the
+// same expressions the physics used inline, so lookups are bit-exact.
+struct ThrustTable {
+    alignas(32) double packed[181][5][4];
+
+    ThrustTable() {
+        for (int rotate = -90; rotate <= 90; ++rotate) {
+            double rad = rotate * M_PI / 180.0;
+            for (int power = 0; power <= 4; ++power) {
+                double* entry = packed[rotate + 90][power];
+                entry[0] = -power * sin(rad);
+                entry[1] = power * cos(rad) - GRAVITY;
+                entry[2] = power;
+                entry[3] = 0;
             }
         }
+    }
 
-        double distance = abs(state.x - (landingStartX + landingEndX) / 2);
-        return -distance;
+    const double* at(int rotate, int power) const {
+        return packed[rotate + 90][power];
     }
 };
 
-double simulate(Chromosome& chromosome, GameState state, const pair<int, int> surface[MAX_SURFACE_POINTS], int surfaceN) {
+const ThrustTable THRUST;
+
+// Advances the lander by one turn with an already clamped command
+inline void applyCommand(GameState& state, int newRotate, int newPower) {
+    const double* thrust = THRUST.at(newRotate, newPower);
+    double hAcc = thrust[0];
+    double vAcc = thrust[1];
+
+    state.x += state.hSpeed + 0.5 * hAcc;
+    state.y += state.vSpeed + 0.5 * vAcc;
+    state.hSpeed += hAcc;
+    state.vSpeed += vAcc;
+
+    state.fuel -= newPower;
+    state.rotate = newRotate;
+    state.power = newPower;
+}
+
+template <class Config>
+double simulate(const Chromosome<Config>& chromosome, GameState state, const Terrain& terrain) {
+    constexpr int CHROMOSOME_SIZE = Config::CHROMOSOME_SIZE;
+    int touchdown = IN_FLIGHT;
     for (int i = 0; i < CHROMOSOME_SIZE; ++i) {
         int newRotate = max(-90, min(90, state.rotate + chromosome.genes[i].rotate));
         int newPower = max(0, min(4, state.power + chromosome.genes[i].power));
+        double x = state.x, y = state.y;
+        applyCommand(state, newRotate, newPower);
 
-        double rad = newRotate * M_PI / 180.0;
-        double hAcc = -newPower * sin(rad);
-        double vAcc = newPower * cos(rad) - GRAVITY;
+        touchdown = terrain.touchdown(x, y, state.x, state.y);
+        if (touchdown != IN_FLIGHT) {
+            break;
+        }
+    }
+    return chromosome.calculateFitness(state, touchdown, terrain);
+}
 
-        state.x += state.hSpeed + 0.5 * hAcc;
-        state.y += state.vSpeed + 0.5 * vAcc;
-        state.hSpeed += hAcc;
-        state.vSpeed += vAcc;
+typedef double SimdDouble __attribute__((vector_size(SIM_LANES * sizeof(double))));
+typedef long long SimdMask __attribute__((vector_size(SIM_LANES * sizeof(long long))));
 
-        state.fuel -= newPower;
+// Turns four packed thrust rows (one per lane) into hAcc / vAcc / power vectors
+inline void transposeThrust(const double* const rows[SIM_LANES], SimdDouble& hAcc, SimdDouble& vAcc, SimdDouble& power) {
+    __m256d r0 = _mm256_load_pd(rows[0]), r1 = _mm256_load_pd(rows[1]);
+    __m256d r2 = _mm256_load_pd(rows[2]), r3 = _mm256_load_pd(rows[3]);
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1); // h0 h1 p0 p1
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1); // v0 v1 0 0
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3); // h2 h3 p2 p3
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3); // v2 v3 0 0
+    hAcc = (SimdDouble)_mm256_permute2f128_pd(t0, t2, 0x20);
+    vAcc = (SimdDouble)_mm256_permute2f128_pd(t1, t3, 0x20);
+    power = (SimdDouble)_mm256_permute2f128_pd(t0, t2, 0x31);
+}
 
-        if (state.y <= 0) {
-            break;
+// LANE_WEIGHTS.of[bits][l] is 1.0 when bit l is set, turning a lane bit set
+// into an arithmetic weight with a single load
+struct LaneWeights {
+    SimdDouble of[1 << SIM_LANES];
+
+    LaneWeights() {
+        for (int bits = 0; bits < (1 << SIM_LANES); ++bits) {
+            for (int l = 0; l < SIM_LANES; ++l) {
+                of[bits][l] = (bits >> l & 1) ? 1.0 : 0.0;
+            }
+        }
+    }
+};
+
+const LaneWeights LANE_WEIGHTS;
+
+// Simulates up to SIM_LANES chromosomes side by side in structure-of-arrays
+// form, one lane per double of an AVX2 register. Each lane's command is a
+// single table load and the physics runs on whole registers. Lanes that are
+// not flying are weighted by 0 instead of leaving the loop; adding 0 * delta
+// keeps their state as it was and 1 * delta is exact, so every lane follows
+// the operation order of simulate() bit for bit, including the per-step
+// terrain collision test.
+//
+// Each lane resumes from the last checkpoint before its first dirty gene,
+// stays at weight 0 until the loop reaches that step and refreshes the
+// checkpoints it passes.
+template <class Config>
+void simulateBatch(Chromosome<Config>* const* batch, int count, const GameState& state, const Terrain& terrain) {
+    constexpr int CHROMOSOME_SIZE = Config::CHROMOSOME_SIZE;
+    SimdDouble x, y, hSpeed, vSpeed, fuel;
+    int rotate[SIM_LANES], power[SIM_LANES], start[SIM_LANES], touchdown[SIM_LANES];
+    const Gene* genes[SIM_LANES];
+
+    int first = CHROMOSOME_SIZE;
+    for (int l = 0; l < SIM_LANES; ++l) {
+        Chromosome<Config>& chromosome = *batch[l < count ? l : 0];
+        int checkpoint = chromosome.dirtyFrom / CHECKPOINT_INTERVAL;
+        if (checkpoint == 0) {
+            chromosome.checkpoints[0] = state;
+        }
+        const GameState& from = chromosome.checkpoints[checkpoint];
+        x[l] = from.x;
+        y[l] = from.y;
+        hSpeed[l] = from.hSpeed;
+        vSpeed[l] = from.vSpeed;
+        fuel[l] = from.fuel;
+        rotate[l] = from.rotate;
+        power[l] = from.power;
+        start[l] = l < count ? checkpoint * CHECKPOINT_INTERVAL : CHROMOSOME_SIZE;
+        genes[l] = chromosome.genes;
+        touchdown[l] = IN_FLIGHT;
+        chromosome.usedGenes = CHROMOSOME_SIZE;
+        first = min(first, start[l]);
+    }
+
+    // Bit l is set while lane l is flying; lanes still waiting for their
+    // checkpoint are in waitingBits. Starts are multiples of CHECKPOINT_INTERVAL,
+    // so lanes only join or save state at segment boundaries.
+    int aliveBits = 0, waitingBits = (1 << count) - 1;
+    const SimdDouble zero = {};
+    const SimdDouble ceiling = zero + terrain.highest;
+    const SimdDouble width = zero + MAP_WIDTH;
+    const SimdDouble height = zero + MAP_HEIGHT;
+    for (int segment = first; segment < CHROMOSOME_SIZE && (aliveBits || waitingBits); segment += CHECKPOINT_INTERVAL) {
+        alignas(32) double lane[5][SIM_LANES];
+        _mm256_store_pd(lane[0], (__m256d)x);
+        _mm256_store_pd(lane[1], (__m256d)y);
+        _mm256_store_pd(lane[2], (__m256d)hSpeed);
+        _mm256_store_pd(lane[3], (__m256d)vSpeed);
+        _mm256_store_pd(lane[4], (__m256d)fuel);
+        for (int l = 0; l < count; ++l) {
+            if (start[l] == segment) {
+                aliveBits |= 1 << l;
+                waitingBits &= ~(1 << l);
+            } else if (aliveBits >> l & 1) {
+                GameState& checkpoint = batch[l]->checkpoints[segment / CHECKPOINT_INTERVAL];
+                checkpoint.x = lane[0][l];
+                checkpoint.y = lane[1][l];
+                checkpoint.hSpeed = lane[2][l];
+                checkpoint.vSpeed = lane[3][l];
+                checkpoint.fuel = (int)lane[4][l];
+                checkpoint.rotate = rotate[l];
+                checkpoint.power = power[l];
+            }
+        }
+
+        for (int i = segment; i < segment + CHECKPOINT_INTERVAL; ++i) {
+            const double* rows[SIM_LANES];
+            for (int l = 0; l < SIM_LANES; ++l) {
+                const Gene& gene = genes[l][i];
+                int newRotate = max(-90, min(90, rotate[l] + gene.rotate));
+                int newPower = max(0, min(4, power[l] + gene.power));
+                bool flying = aliveBits >> l & 1;
+                rotate[l] = flying ? newRotate : rotate[l];
+                power[l] = flying ? newPower : power[l];
+                rows[l] = THRUST.at(rotate[l], power[l]);
+            }
+            SimdDouble hAcc, vAcc, thrust;
+            transposeThrust(rows, hAcc, vAcc, thrust);
+
+            const SimdDouble alive = LANE_WEIGHTS.of[aliveBits];
+            const SimdDouble prevX = x, prevY = y;
+            x += alive * (hSpeed + 0.5 * hAcc);
+            y += alive * (vSpeed + 0.5 * vAcc);
+            hSpeed += alive * hAcc;
+            vSpeed += alive * vAcc;
+            fuel -= alive * thrust;
+
+            // Lanes above every peak and inside the map cannot have hit
+            // anything; the rest go through the terrain index one by one
+            SimdMask clear = (prevY > ceiling) & (y > ceiling) & (x >= zero) & (x < width) & (y < height);
+            int suspect = aliveBits & ~_mm256_movemask_pd((__m256d)clear);
+            if (suspect) {
+                alignas(32) double moved[4][SIM_LANES];
+                _mm256_store_pd(moved[0], (__m256d)prevX);
+                _mm256_store_pd(moved[1], (__m256d)prevY);
+                _mm256_store_pd(moved[2], (__m256d)x);
+                _mm256_store_pd(moved[3], (__m256d)y);
+                for (; suspect; suspect &= suspect - 1) {
+                    int l = __builtin_ctz(suspect);
+                    touchdown[l] = terrain.touchdown(moved[0][l], moved[1][l], moved[2][l], moved[3][l]);
+                    if (touchdown[l] != IN_FLIGHT) {
+                        batch[l]->usedGenes = i + 1;
+                        aliveBits &= ~(1 << l);
+                    }
+                }
+            }
+            if (!aliveBits && !waitingBits) {
+                break;
+            }
+        }
+    }
+
+    for (int l = 0; l < count; ++l) {
+        GameState end = state;
+        end.x = x[l];
+        end.y = y[l];
+        end.hSpeed = hSpeed[l];
+        end.vSpeed = vSpeed[l];
+        end.fuel = (int)fuel[l];
+        end.rotate = rotate[l];
+        end.power = power[l];
+        batch[l]->fitness = batch[l]->calculateFitness(end, touchdown[l], terrain);
+        batch[l]->dirtyFrom = CHROMOSOME_SIZE;
+
+#ifdef VERIFY_SIMD
+        double reference = simulate(*batch[l], state, terrain);
+        if (abs(batch[l]->fitness - reference) > SIMD_TOLERANCE) {
+            cerr << "simulateBatch mismatch: " << batch[l]->fitness << " vs " << reference << endl;
+        }
+#endif
+    }
+}
+
+// Re-simulates only chromosomes whose played genes changed since their last
+// evaluation against 'state' and returns how many that were. Candidates are
+// grouped by the checkpoint they resume from so lanes of a batch start
+// together. MaxCount bounds 'count' and sizes the buckets.
+template <class Config, int MaxCount>
+int evaluateChromosomes(Chromosome<Config>* candidates, int count, const GameState& state, const Terrain& terrain) {
+    constexpr int CHECKPOINTS = Config::CHECKPOINTS;
+    Chromosome<Config>* pending[CHECKPOINTS][MaxCount];
+    int pendingCount[CHECKPOINTS] = {};
+    int simulated = 0;
+    for (int i = 0; i < count; ++i) {
+        Chromosome<Config>& chromosome = candidates[i];
+        if constexpr (Config::HOLDS) {
+            chromosome.decode(state.rotate, state.power);
+        }
+        if (chromosome.dirtyFrom >= chromosome.usedGenes) {
+            chromosome.dirtyFrom = Config::CHROMOSOME_SIZE;
+            continue;
+        }
+        int checkpoint = chromosome.dirtyFrom / CHECKPOINT_INTERVAL;
+        pending[checkpoint][pendingCount[checkpoint]++] = &chromosome;
+        ++simulated;
+    }
+
+    Chromosome<Config>* batch[SIM_LANES];
+    int batched = 0;
+    for (int k = 0; k < CHECKPOINTS; ++k) {
+        for (int j = 0; j < pendingCount[k]; ++j) {
+            batch[batched++] = pending[k][j];
+            if (batched == SIM_LANES) {
+                simulateBatch(batch, batched, state, terrain);
+                batched = 0;
+            }
         }
     }
-    return chromosome.calculateFitness(state, surface, surfaceN);
+    if (batched > 0) {
+        simulateBatch(batch, batched, state, terrain);
+    }
+    return simulated;
 }
 
+template <class Config>
 class GeneticPopulation {
 public:
-    Chromosome population[POPULATION_SIZE];
-    Chromosome newPopulation[POPULATION_SIZE];
+    static constexpr int CHROMOSOME_SIZE = Config::CHROMOSOME_SIZE;
+    static constexpr int POPULATION_SIZE = Config::POPULATION_SIZE;
+    static constexpr int ELITS = Config::ELITS;
+    static constexpr int TOURNAMENT_SIZE = Config::TOURNAMENT_SIZE;
+    static constexpr int CHECKPOINTS = Config::CHECKPOINTS;
+    typedef ::Chromosome<Config> Chromosome;
+
+    // Two generation buffers; evolve() writes the next generation into
+    // newPopulation and swaps the pointers instead of copying it back.
+    Chromosome buffers[2][POPULATION_SIZE];
+    Chromosome* population;
+    Chromosome* newPopulation;
+    int order[POPULATION_SIZE];
+    perf::Rng rng;
+    long long simulations; // Chromosomes simulated so far, for throughput reports
 
-    GeneticPopulation() {
+    explicit GeneticPopulation(uint64_t seed) : population(buffers[0]), newPopulation(buffers[1]), rng(seed), simulations(0) {
         for (int i = 0; i < POPULATION_SIZE; ++i) {
-            population[i].initialize();
+            population[i].initialize(rng);
         }
     }
 
-    Chromosome tournamentSelection() {
-        Chromosome best = population[rand() % POPULATION_SIZE]; // Initialize with a random chromosome
+    int tournamentSelection() {
+        int best = rng.nextInt(POPULATION_SIZE); // Start with a random chromosome
 
         for (int i = 1; i < TOURNAMENT_SIZE; ++i) {
-            int index = rand() % POPULATION_SIZE;
-            if (population[index].fitness > best.fitness) {
-                best = population[index];
+            int index = rng.nextInt(POPULATION_SIZE);
+            if (population[index].fitness > population[best].fitness) {
+                best = index;
             }
         }
         return best;
     }
 
-    void evolve(const GameState& state, const pair<int, int> surface[MAX_SURFACE_POINTS], int surfaceN) {
-        sort(population, population + POPULATION_SIZE, [](const Chromosome& a, const Chromosome& b) {
-            return a.fitness > b.fitness;
-        });
+    // Each operator runs over the whole generation in its own profiler zone,
+    // so the benchmark can time them apart
+    void evolve(const GameState& state, const Terrain& terrain) {
+        int parents[POPULATION_SIZE][2];
+        {
+            PERF_ZONE(PHASE_NAMES[PHASE_SELECTION]);
+            // Only the elites have to be ordered, so sort indices and stop after ELITS
+            for (int i = 0; i < POPULATION_SIZE; ++i) {
+                order[i] = i;
+            }
+            partial_sort(order, order + ELITS, order + POPULATION_SIZE, [this](int a, int b) {
+                return population[a].fitness > population[b].fitness;
+            });
+
+            for (int i = 0; i < ELITS; ++i) {
+                newPopulation[i] = population[order[i]];
+            }
+
+            for (int i = ELITS; i < POPULATION_SIZE; ++i) {
+                parents[i][0] = tournamentSelection();
+                parents[i][1] = tournamentSelection();
+            }
+        }
+        {
+            PERF_ZONE(PHASE_NAMES[PHASE_CROSSOVER]);
+            for (int i = ELITS; i < POPULATION_SIZE; ++i) {
+                crossover(population[parents[i][0]], population[parents[i][1]], newPopulation[i]);
+            }
+        }
+        {
+            PERF_ZONE(PHASE_NAMES[PHASE_MUTATION]);
+            for (int i = ELITS; i < POPULATION_SIZE; ++i) {
+                newPopulation[i].mutate(rng);
+            }
+        }
+
+        swap(population, newPopulation);
+
+        // Elites are unchanged and keep their fitness for the same state
+        PERF_ZONE(PHASE_NAMES[PHASE_SIMULATION]);
+        evaluate(ELITS, state, terrain);
+    }
+
+    void evaluate(int from, const GameState& state, const Terrain& terrain) {
+        simulations += evaluateChromosomes<Config, POPULATION_SIZE>(population + from, POPULATION_SIZE - from, state, terrain);
+    }
+
+    void crossover(const Chromosome& parent1, const Chromosome& parent2, Chromosome& child) {
+        // Blend child = b + r * (a - b) in 16-bit fixed point, rounded to the
+        // nearest integer. It is exact where the parents agree, so shared genes
+        // stay shared, and it never leaves the range spanned by the parents.
+        // Rotate and power use the same weight, so blend them as one int array.
+        const int weight = (int)(rng.nextDouble() * 65536);
+        if constexpr (Config::HOLDS) {
+            // Start from parent1 and its evaluation; decoding at evaluation
+            // finds the first frame the blend changed
+            child = parent1;
+            int* c = child.slots();
+            const int* b = parent2.slots();
+            for (int j = 0; j < Chromosome::SLOTS; ++j) {
+                c[j] = b[j] + ((weight * (c[j] - b[j]) + 0x8000) >> 16);
+            }
+            return;
+        }
 
-        for (int i = 0; i < ELITS; ++i) {
-            newPopulation[i] = population[i];
+        const int* a = &parent1.genes[0].rotate;
+        const int* b = &parent2.genes[0].rotate;
+        int* c = &child.genes[0].rotate;
+        for (int j = 0; j < 2 * CHROMOSOME_SIZE; ++j) {
+            c[j] = b[j] + ((weight * (a[j] - b[j]) + 0x8000) >> 16);
         }
 
-        for (int i = ELITS; i < POPULATION_SIZE; ++i) {
-            Chromosome parent1 = tournamentSelection();
-            Chromosome parent2 = tournamentSelection();
-            Chromosome child = crossover(parent1, parent2);
-            child.mutate();
-            newPopulation[i] = child;
+        // Reuse the evaluation of the parent sharing the longer prefix
+        int prefix1 = sharedPrefix(child, parent1);
+        int prefix2 = sharedPrefix(child, parent2);
+        if (prefix1 >= prefix2) {
+            child.inheritFrom(parent1, prefix1);
+        } else {
+            child.inheritFrom(parent2, prefix2);
         }
+    }
 
+    static int sharedPrefix(const Chromosome& a, const Chromosome& b) {
+        return mismatch(a.genes, a.genes + CHROMOSOME_SIZE, b.genes, [](const Gene& x, const Gene& y) {
+            return x.rotate == y.rotate && x.power == y.power;
+        }).first - a.genes;
+    }
+
+    // Rolls the plan forward one turn after its first gene has been played:
+    // every chromosome drops that gene and gets a fresh random tail gene.
+    // Fitness is stale afterwards and has to be re-evaluated on the new state.
+    void shift() {
         for (int i = 0; i < POPULATION_SIZE; ++i) {
-            population[i] = newPopulation[i];
+            population[i].shift(rng);
         }
+    }
 
+    void invalidate() {
         for (int i = 0; i < POPULATION_SIZE; ++i) {
-            population[i].fitness = simulate(population[i], state, surface, surfaceN);
+            population[i].dirtyFrom = 0;
         }
     }
 
-    Chromosome crossover(const Chromosome& parent1, const Chromosome& parent2) {
-        Chromosome child;
-        double random = (double)rand() / RAND_MAX;
+    // Overwrites the worst chromosomes with already evaluated migrants
+    void receive(const Chromosome* migrants, int count) {
+        for (int m = 0; m < count; ++m) {
+            int worst = 0;
+            for (int i = 1; i < POPULATION_SIZE; ++i) {
+                if (population[i].fitness < population[worst].fitness) {
+                    worst = i;
+                }
+            }
+            population[worst] = migrants[m];
+        }
+    }
 
-        for (int i = 0; i < CHROMOSOME_SIZE; ++i) {
-            child.genes[i].rotate = random * parent1.genes[i].rotate + (1 - random) * parent2.genes[i].rotate;
-            child.genes[i].power = random * parent1.genes[i].power + (1 - random) * parent2.genes[i].power;
-            child.genes[i].rotate = max(-90, min(90, child.genes[i].rotate));
-            child.genes[i].power = max(-1, min(1, child.genes[i].power));
+    double meanFitness() const {
+        double sum = 0;
+        for (int i = 0; i < POPULATION_SIZE; ++i) {
+            sum += population[i].fitness;
         }
-        return child;
+        return sum / POPULATION_SIZE;
     }
 
-    Chromosome getBestChromosome() {
-        Chromosome best = population[0];
+    const Chromosome& getBestChromosome() const {
+        int best = 0;
         for (int i = 1; i < POPULATION_SIZE; ++i) {
-            if (population[i].fitness > best.fitness) {
-                best = population[i];
+            if (population[i].fitness > population[best].fitness) {
+                best = i;
             }
         }
-        return best;
+        return population[best];
     }
 };
 
 
+// A search method over the shared plan encoding. Pilot drives any of them
+// the same way: evaluate on the turn's state, step until the budget runs
+// out, play the first gene of the best plan, then shift.
+template <class Config>
+class Optimizer {
+public:
+    virtual ~Optimizer() {}
 
-void printGameState(const GameState& state) {
-    cerr << fixed << setprecision(2); // Print with 2 decimal places
-    cerr << "Calculated GameState:" << endl;
-    cerr << "X: " << state.x << " Y: " << state.y << endl;
-    cerr << "HSpeed: " << state.hSpeed << " VSpeed: " << state.vSpeed << endl;
-    cerr << "Fuel: " << state.fuel << endl;
-    cerr << "Rotate: " << state.rotate << " Power: " << state.power << endl;
-    cerr << "-------------------------" << endl;
+    // Brings every fitness up to date for a new root state
+    virtual void evaluate(const GameState& state, const Terrain& terrain) = 0;
+    // One iteration of the search
+    virtual void step(const GameState& state, const Terrain& terrain) = 0;
+    // Drops the gene that has just been played from every plan
+    virtual void shift() = 0;
+    // Marks every fitness stale after the root state moved under the search
+    virtual void invalidate() = 0;
+    virtual const Chromosome<Config>& getBestChromosome() const = 0;
+    virtual long long simulationCount() const = 0;
+    // Mean fitness of the candidates the last step evaluated
+    virtual double meanFitness() const = 0;
+};
+
+template <class Config>
+class GeneticOptimizer : public Optimizer<Config> {
+public:
+    GeneticPopulation<Config> population;
+
+    explicit GeneticOptimizer(uint64_t seed) : population(seed) {}
+
+    void evaluate(const GameState& state, const Terrain& terrain) override { population.evaluate(0, state, terrain); }
+    void step(const GameState& state, const Terrain& terrain) override { population.evolve(state, terrain); }
+    void shift() override { population.shift(); }
+    void invalidate() override { population.invalidate(); }
+    const Chromosome<Config>& getBestChromosome() const override { return population.getBestChromosome(); }
+    long long simulationCount() const override { return population.simulations; }
+    double meanFitness() const override { return population.meanFitness(); }
+};
+
+// Simulated annealing on a single plan: every step tries SIM_LANES mutated
+// neighbours in one batch and accepts each by the Metropolis rule. The
+// temperature cools geometrically and is reset every turn.
+template <class Config>
+class AnnealingOptimizer : public Optimizer<Config> {
+public:
+    static constexpr double START_TEMPERATURE = 500;
+    static constexpr double MIN_TEMPERATURE = 1;
+    static constexpr double COOLING = 0.999;
+    typedef ::Chromosome<Config> Chromosome;
+
+    Chromosome current, best;
+    Chromosome neighbours[SIM_LANES];
+    double temperature;
+    perf::Rng rng;
+    long long simulations;
+
+    explicit AnnealingOptimizer(uint64_t seed) : temperature(START_TEMPERATURE), rng(seed), simulations(0) {
+        current.initialize(rng);
+        best = current;
+    }
+
+    void evaluate(const GameState& state, const Terrain& terrain) override {
+        simulations += evaluateChromosomes<Config, 1>(&current, 1, state, terrain);
+        simulations += evaluateChromosomes<Config, 1>(&best, 1, state, terrain);
+        if (current.fitness > best.fitness) {
+            best = current;
+        }
+    }
+
+    void step(const GameState& state, const Terrain& terrain) override {
+        for (Chromosome& neighbour : neighbours) {
+            neighbour = current;
+            neighbour.mutate(rng);
+        }
+        simulations += evaluateChromosomes<Config, SIM_LANES>(neighbours, SIM_LANES, state, terrain);
+
+        for (const Chromosome& neighbour : neighbours) {
+            double gain = neighbour.fitness - current.fitness;
+            if (gain >= 0 || rng.nextDouble() < exp(gain / temperature)) {
+                current = neighbour;
+                if (current.fitness > best.fitness) {
+                    best = current;
+                }
+            }
+        }
+        temperature = max(MIN_TEMPERATURE, temperature * COOLING);
+    }
+
+    void shift() override {
+        current.shift(rng);
+        best.shift(rng);
+        temperature = START_TEMPERATURE;
+    }
+
+    void invalidate() override {
+        current.dirtyFrom = 0;
+        best.dirtyFrom = 0;
+    }
+
+    const Chromosome& getBestChromosome() const override { return best; }
+    long long simulationCount() const override { return simulations; }
+
+    double meanFitness() const override {
+        double sum = 0;
+        for (const Chromosome& neighbour : neighbours) {
+            sum += neighbour.fitness;
+        }
+        return sum / SIM_LANES;
+    }
+};
+
+// Cross-entropy method: an independent normal per rotate and power slot is
+// sampled into POPULATION_SIZE plans, and the ELITS best pull the means and
+// deviations towards themselves. Samples are rounded onto the gene ranges.
+template <class Config>
+class CrossEntropyOptimizer : public Optimizer<Config> {
+public:
+    static constexpr int CHROMOSOME_SIZE = Config::CHROMOSOME_SIZE;
+    static constexpr int POPULATION_SIZE = Config::POPULATION_SIZE;
+    static constexpr int ELITS = Config::ELITS;
+    static constexpr double SMOOTHING = 0.7;  // Weight of the elites in each update
+    static constexpr double MIN_SIGMA = 0.3;  // Keeps a little exploration on every slot
+    typedef ::Chromosome<Config> Chromosome;
+
+    Chromosome samples[POPULATION_SIZE];
+    Chromosome best;
+    static constexpr int SLOTS = Chromosome::SLOTS;
+    double mean[SLOTS];  // Per Chromosome::slots() entry
+    double sigma[SLOTS];
+    int order[POPULATION_SIZE];
+    perf::Rng rng;
+    long long simulations;
+
+    explicit CrossEntropyOptimizer(uint64_t seed) : rng(seed), simulations(0) {
+        for (int slot = 0; slot < SLOTS; ++slot) {
+            widen(slot);
+        }
+        best.initialize(rng);
+    }
+
+    void evaluate(const GameState& state, const Terrain& terrain) override {
+        simulations += evaluateChromosomes<Config, 1>(&best, 1, state, terrain);
+    }
+
+    void step(const GameState& state, const Terrain& terrain) override {
+        for (Chromosome& sample : samples) {
+            int* values = sample.slots();
+            for (int slot = 0; slot < SLOTS; ++slot) {
+                int value = (int)lround(mean[slot] + sigma[slot] * rng.nextGaussian());
+                values[slot] = max(Chromosome::slotMin(slot), min(Chromosome::slotMax(slot), value));
+            }
+            sample.dirtyFrom = 0;
+        }
+        simulations += evaluateChromosomes<Config, POPULATION_SIZE>(samples, POPULATION_SIZE, state, terrain);
+
+        for (int i = 0; i < POPULATION_SIZE; ++i) {
+            order[i] = i;
+        }
+        partial_sort(order, order + ELITS, order + POPULATION_SIZE, [this](int a, int b) {
+            return samples[a].fitness > samples[b].fitness;
+        });
+        if (samples[order[0]].fitness > best.fitness) {
+            best = samples[order[0]];
+        }
+
+        for (int slot = 0; slot < SLOTS; ++slot) {
+            double sum = 0, squares = 0;
+            for (int e = 0; e < ELITS; ++e) {
+                double value = samples[order[e]].slots()[slot];
+                sum += value;
+                squares += value * value;
+            }
+            double eliteMean = sum / ELITS;
+            double eliteSigma = sqrt(max(0.0, squares / ELITS - eliteMean * eliteMean));
+            mean[slot] += SMOOTHING * (eliteMean - mean[slot]);
+            sigma[slot] = max(MIN_SIGMA, sigma[slot] + SMOOTHING * (eliteSigma - sigma[slot]));
+        }
+    }
+
+    // Holds only lose a frame per turn, so their distribution is kept
+    void shift() override {
+        if constexpr (!Chromosome::HOLDS) {
+            move(mean + 2, mean + SLOTS, mean);
+            move(sigma + 2, sigma + SLOTS, sigma);
+            widen(SLOTS - 2);
+            widen(SLOTS - 1);
+        }
+        best.shift(rng);
+    }
+
+    void invalidate() override { best.dirtyFrom = 0; }
+
+    const Chromosome& getBestChromosome() const override { return best; }
+    long long simulationCount() const override { return simulations; }
+
+    double meanFitness() const override {
+        double sum = 0;
+        for (const Chromosome& sample : samples) {
+            sum += sample.fitness;
+        }
+        return sum / POPULATION_SIZE;
+    }
+
+private:
+    // Resets a slot to a wide distribution over its whole range
+    void widen(int slot) {
+        mean[slot] = (Chromosome::slotMin(slot) + Chromosome::slotMax(slot)) / 2.0;
+        sigma[slot] = (Chromosome::slotMax(slot) - Chromosome::slotMin(slot)) / 2.0;
+    }
+};
+
+const char* const OPTIMIZER_NAMES[] = {"ga", "sa", "cem"};
+
+template <class Config>
+Optimizer<Config>* createOptimizer(const string& name, uint64_t seed) {
+    if (name == "sa") {
+        return new AnnealingOptimizer<Config>(seed);
+    }
+    if (name == "cem") {
+        return new CrossEntropyOptimizer<Config>(seed);
+    }
+    if (name != "ga") {
+        cerr << "unknown optimizer " << name << ", using ga" << endl;
+    }
+    return new GeneticOptimizer<Config>(seed);
 }
 
-int main() {
-    srand(time(0));
+#ifdef TELEMETRY
+enum TelemetryKind : uint8_t {
+    TELEMETRY_GENERATION, // index = generation, a = best fitness, b = mean fitness
+    TELEMETRY_TURN,       // index = generations, a = generations, b = milliseconds spent
+    TELEMETRY_TRAJECTORY, // index = step of the best plan, a = x, b = y
+    TELEMETRY_DROPPED,    // index = records lost to a full ring since the last flush
+};
 
-    int surfaceN;
-    cin >> surfaceN;
-    pair<int, int> surface[MAX_SURFACE_POINTS];
-    for (int i = 0; i < surfaceN; ++i) {
-        cin >> surface[i].first >> surface[i].second;
-        if (i > 0 && surface[i].second == surface[i - 1].second) {
-            landingStartX = surface[i - 1].first;
-            landingEndX = surface[i].first;
-            landingY = surface[i].second;
+struct TelemetryRecord {
+    uint8_t kind;
+    uint8_t reserved;
+    uint16_t turn;
+    uint32_t index;
+    float a, b;
+};
+
+// Opt-in binary trace of the search (build with -DTELEMETRY). Records are
+// appended to a preallocated ring during the turn and only written to the
+// file by flush(), between turns. A full ring drops new records and says
+// how many in the stream. The file starts with "MLTL", a version and the
+// record size; MarsLander/telemetry_to_csv.py turns it into CSV.
+class Telemetry {
+public:
+    static constexpr uint32_t CAPACITY = 1 << 16; // Records; a power of two
+    static constexpr uint32_t VERSION = 1;
+
+    Telemetry() : ring(new TelemetryRecord[CAPACITY]), file(nullptr), head(0), tail(0), dropped(0) {}
+
+    ~Telemetry() {
+        if (file) {
+            flush();
+            fclose(file);
         }
     }
 
-    GeneticPopulation gp;
+    bool open(const string& path) {
+        file = fopen(path.c_str(), "wb");
+        if (!file) {
+            cerr << "cannot write telemetry to " << path << endl;
+            return false;
+        }
+        uint32_t header[3] = {0x4C544C4D, VERSION, sizeof(TelemetryRecord)}; // "MLTL"
+        fwrite(header, sizeof(header), 1, file);
+        return true;
+    }
 
-    GameState state;
-    cin >> state.x >> state.y >> state.hSpeed >> state.vSpeed >> state.fuel >> state.rotate >> state.power;
+    void record(TelemetryKind kind, int turn, uint32_t index, double a, double b) {
+        if (tail - head == CAPACITY) {
+            ++dropped;
+            return;
+        }
+        ring[tail++ & (CAPACITY - 1)] = {kind, 0, (uint16_t)turn, index, (float)a, (float)b};
+    }
 
-    for (int i = 0; i < POPULATION_SIZE; ++i) {
-        gp.population[i].fitness = simulate(gp.population[i], state, surface, surfaceN);
+    void flush() {
+        if (!file) {
+            head = tail;
+            return;
+        }
+        while (head != tail) {
+            uint32_t start = head & (CAPACITY - 1);
+            uint32_t count = min(tail - head, CAPACITY - start);
+            fwrite(&ring[start], sizeof(TelemetryRecord), count, file);
+            head += count;
+        }
+        if (dropped) {
+            TelemetryRecord lost = {TELEMETRY_DROPPED, 0, 0, dropped, 0, 0};
+            fwrite(&lost, sizeof(lost), 1, file);
+            dropped = 0;
+        }
+        fflush(file);
     }
 
-    auto start = high_resolution_clock::now();
-    while (duration_cast<milliseconds>(high_resolution_clock::now() - start).count() < 99) {
-        gp.evolve(state, surface, surfaceN);
+private:
+    unique_ptr<TelemetryRecord[]> ring;
+    FILE* file;
+    uint32_t head, tail; // Free-running; masked on access
+    uint32_t dropped;
+};
+#endif
+
+// The bot itself: keeps one search alive across turns and answers every
+// state with a command
+template <class Config>
+class Pilot {
+public:
+    unique_ptr<Optimizer<Config>> optimizer;
+    perf::DeadlineTimer budget;
+    int turn;
+    long long generations; // Optimizer steps run on the last turn
+
+#ifdef TELEMETRY
+    Telemetry telemetry;
+#endif
+
+#ifdef PONDER
+    thread ponderer;
+    atomic<bool> stopPondering;
+    bool pondered;           // The optimizer already searched ahead of this turn
+    GameState predicted;     // State the ponderer searches from
+    long long pondering;     // Optimizer steps run while waiting for the last turn
+#endif
+
+    explicit Pilot(uint64_t seed, const string& method = "ga")
+        : optimizer(createOptimizer<Config>(method, seed)), turn(0), generations(0) {
+#ifdef PONDER
+        stopPondering = false;
+        pondered = false;
+        pondering = 0;
+#endif
     }
 
-    Chromosome best = gp.getBestChromosome();
-    int newRotate = max(-90, min(90, state.rotate + best.genes[0].rotate));
-    int newPower = max(0, min(4, state.power + best.genes[0].power));
-    cout << newRotate << " " << newPower << endl;
+#ifdef PONDER
+    ~Pilot() {
+        stopPonder();
+    }
 
-    double rad = newRotate * M_PI / 180.0;
-    double hAcc = -newPower * sin(rad);
-    double vAcc = newPower * cos(rad) - GRAVITY;
+    // Keeps searching from the state the last command should lead to while
+    // the caller waits for the real one. The optimizer belongs to the
+    // ponderer until the next decide() stops it, so no locking is needed.
+    void ponder(const GameState& next, const Terrain& terrain) {
+        stopPonder();
+        predicted = next;
+        stopPondering = false;
+        pondered = true;
+        ponderer = thread([this, &terrain] {
+            optimizer->shift();
+            optimizer->evaluate(predicted, terrain);
+            long long steps = 0;
+            while (!stopPondering.load(memory_order_relaxed)) {
+                optimizer->step(predicted, terrain);
+                ++steps;
+            }
+            pondering = steps;
+        });
+    }
 
-    state.x += state.hSpeed + 0.5 * hAcc;
-    state.y += state.vSpeed + 0.5 * vAcc;
-    state.hSpeed += hAcc;
-    state.vSpeed += vAcc;
+    void stopPonder() {
+        if (ponderer.joinable()) {
+            stopPondering = true;
+            ponderer.join();
+        }
+    }
+#endif
 
-    state.fuel -= newPower;
-    state.rotate = newRotate;
-    state.power = newPower;
-    printGameState(state);
+    // Searches for the turn's time limit, or 'milliseconds' when positive,
+    // or exactly 'fixedGenerations' when that is positive, and returns the
+    // absolute rotate and power to play. The limit counts from 'begin', the
+    // moment the turn's input started arriving.
+    Gene decide(const GameState& state, const Terrain& terrain, double milliseconds = 0, long long fixedGenerations = 0,
+                steady_clock::time_point begin = steady_clock::now()) {
+        if (milliseconds <= 0) {
+            milliseconds = (turn == 0 ? FIRST_TURN_MS : TURN_MS) - RESPONSE_MARGIN_MS;
+        }
+
+        // Keep the search from the previous turn, re-anchored on the real state
+        bool shifted = false;
+#ifdef PONDER
+        stopPonder();
+        shifted = pondered;
+        pondered = false;
+#endif
+        if (shifted) {
+            // The ponderer already shifted; only its predicted root state was off
+            optimizer->invalidate();
+        } else if (turn > 0) {
+            optimizer->shift();
+        }
+        ++turn;
+        optimizer->evaluate(state, terrain);
+        budget.start(milliseconds, begin);
+
+        generations = 0;
+        while (fixedGenerations > 0 ? generations < fixedGenerations : budget.poll()) {
+            optimizer->step(state, terrain);
+            ++generations;
+#ifdef TELEMETRY
+            telemetry.record(TELEMETRY_GENERATION, turn, generations,
+                             optimizer->getBestChromosome().fitness, optimizer->meanFitness());
+#endif
+        }
+#ifdef TELEMETRY
+        telemetry.record(TELEMETRY_TURN, turn, generations, generations,
+                         duration<double, milli>(steady_clock::now() - begin).count());
+#endif
+
+        const Chromosome<Config>& best = optimizer->getBestChromosome();
+        return Gene(max(-90, min(90, state.rotate + best.genes[0].rotate)),
+                    max(0, min(4, state.power + best.genes[0].power)));
+    }
+
+#ifdef TELEMETRY
+    // Records where the chosen plan expects to fly from 'state' and writes
+    // the turn out; call it once the answer has been sent
+    void report(const GameState& state, const Terrain& terrain) {
+        const Chromosome<Config>& best = optimizer->getBestChromosome();
+        GameState trajectory = state;
+        telemetry.record(TELEMETRY_TRAJECTORY, turn, 0, trajectory.x, trajectory.y);
+        for (int i = 0; i < Config::CHROMOSOME_SIZE; ++i) {
+            int newRotate = max(-90, min(90, trajectory.rotate + best.genes[i].rotate));
+            int newPower = max(0, min(4, trajectory.power + best.genes[i].power));
+            double x = trajectory.x, y = trajectory.y;
+            applyCommand(trajectory, newRotate, newPower);
+            telemetry.record(TELEMETRY_TRAJECTORY, turn, i + 1, trajectory.x, trajectory.y);
+            if (terrain.touchdown(x, y, trajectory.x, trajectory.y) != IN_FLIGHT) {
+                break;
+            }
+        }
+        telemetry.flush();
+    }
+#endif
+};
+
+#ifdef MODE_LOCAL
+// Single-producer single-consumer ring carrying migrants from one island to
+// the next. Each side only writes its own index, so no locks are needed.
+template <class Config>
+class MigrationQueue {
+public:
+    static constexpr int CAPACITY = 8;
+
+    struct Packet {
+        int epoch;
+        Chromosome<Config> migrants[MIGRANTS];
+    };
+
+    MigrationQueue() : head(0), tail(0) {}
+
+    bool push(const Packet& packet) {
+        int t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) == CAPACITY) {
+            return false;
+        }
+        slots[t % CAPACITY] = packet;
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    bool pop(Packet& packet) {
+        int h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire)) {
+            return false;
+        }
+        packet = slots[h % CAPACITY];
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+
+private:
+    Packet slots[CAPACITY];
+    alignas(64) atomic<int> head; // Next packet to read, owned by the consumer
+    alignas(64) atomic<int> tail; // Next slot to write, owned by the producer
+};
+
+// K populations evolving on K threads in a ring: every MIGRATION_INTERVAL
+// generations each island sends its best MIGRANTS to the next one. With a
+// generation budget every island waits for the packet of the current epoch,
+// so a seed reproduces the run exactly; with a time budget islands never
+// wait and take whatever has arrived.
+template <class Config>
+class IslandModel {
+public:
+    static constexpr int POPULATION_SIZE = Config::POPULATION_SIZE;
+    typedef ::Chromosome<Config> Chromosome;
+    typedef ::GeneticPopulation<Config> GeneticPopulation;
+    typedef ::MigrationQueue<Config> MigrationQueue;
+
+    struct Result {
+        Chromosome best;
+        long long generations;
+        double seconds;
+    };
+
+    IslandModel(int islands, uint64_t seed) : islandCount(islands), queues(islands) {
+        for (int i = 0; i < islands; ++i) {
+            populations.emplace_back(new GeneticPopulation(seed + 0x9E3779B97F4A7C15ULL * i));
+        }
+    }
+
+    // Runs until every island did 'generations' generations, or, when that
+    // is 0, until 'milliseconds' have passed
+    Result run(const GameState& state, const Terrain& terrain, long long generations, int milliseconds) {
+        stop.store(false);
+        vector<long long> done(islandCount, 0);
+        auto start = steady_clock::now();
+
+        vector<thread> threads;
+        for (int i = 0; i < islandCount; ++i) {
+            threads.emplace_back([&, i] {
+                GeneticPopulation& island = *populations[i];
+                MigrationQueue& outbox = queues[(i + 1) % islandCount];
+                MigrationQueue& inbox = queues[i];
+                bool deterministic = generations > 0;
+                perf::DeadlineTimer budget(milliseconds, start);
+
+                island.evaluate(0, state, terrain);
+                long long generation = 0;
+                while (deterministic ? generation < generations : budget.poll()) {
+                    island.evolve(state, terrain);
+                    ++generation;
+
+                    if (islandCount > 1 && generation % MIGRATION_INTERVAL == 0) {
+                        exchange(island, outbox, inbox, (int)(generation / MIGRATION_INTERVAL), deterministic);
+                    }
+                }
+                done[i] = generation;
+                stop.store(true);
+            });
+        }
+        for (thread& t : threads) {
+            t.join();
+        }
 
-    while (true) {
-        int dummyX, dummyY, dummyHSpeed, dummyVSpeed, dummyFuel, dummyRotate, dummyPower;
-        cin >> dummyX >> dummyY >> dummyHSpeed >> dummyVSpeed >> dummyFuel >> dummyRotate >> dummyPower;
+        Result result;
+        result.best = populations[0]->getBestChromosome();
+        result.generations = 0;
+        for (int i = 0; i < islandCount; ++i) {
+            const Chromosome& best = populations[i]->getBestChromosome();
+            if (best.fitness > result.best.fitness) {
+                result.best = best;
+            }
+            result.generations += done[i];
+        }
+        result.seconds = duration<double>(steady_clock::now() - start).count();
+        return result;
+    }
 
+private:
+    void exchange(GeneticPopulation& island, MigrationQueue& outbox, MigrationQueue& inbox, int epoch, bool deterministic) {
+        typename MigrationQueue::Packet packet;
+        packet.epoch = epoch;
+        int order[POPULATION_SIZE];
         for (int i = 0; i < POPULATION_SIZE; ++i) {
-            gp.population[i].initialize();
+            order[i] = i;
+        }
+        partial_sort(order, order + MIGRANTS, order + POPULATION_SIZE, [&](int a, int b) {
+            return island.population[a].fitness > island.population[b].fitness;
+        });
+        for (int m = 0; m < MIGRANTS; ++m) {
+            packet.migrants[m] = island.population[order[m]];
+        }
+
+        while (!outbox.push(packet) && deterministic && !stop.load(memory_order_relaxed)) {
+            this_thread::yield();
+        }
+
+        if (deterministic) {
+            while (!inbox.pop(packet)) {
+                if (stop.load(memory_order_relaxed)) {
+                    return;
+                }
+                this_thread::yield();
+            }
+            island.receive(packet.migrants, MIGRANTS);
+        } else {
+            while (inbox.pop(packet)) {
+                island.receive(packet.migrants, MIGRANTS);
+            }
+        }
+    }
+
+    int islandCount;
+    vector<unique_ptr<GeneticPopulation>> populations;
+    vector<MigrationQueue> queues;
+    atomic<bool> stop;
+};
+
+bool loadLevel(const string& path, Terrain& terrain, GameState& state) {
+    ifstream in(path);
+    return terrain.read(in) && state.read(in);
+}
+
+// Searches one level's opening plan offline:
+//   solve <level> [--islands K] [--seed S] [--generations G | --ms T]
+template <class Config>
+int runSolve(int argc, char** argv) {
+    if (argc < 1) {
+        cerr << "usage: solve <level> [--islands K] [--seed S] [--generations G | --ms T]" << endl;
+        return 1;
+    }
+    int islands = max(1, (int)thread::hardware_concurrency());
+    uint64_t seed = 1;
+    long long generations = 0;
+    int milliseconds = 1000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i];
+        if (flag == "--islands") islands = atoi(argv[i + 1]);
+        else if (flag == "--seed") seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (flag == "--generations") generations = atoll(argv[i + 1]);
+        else if (flag == "--ms") milliseconds = atoi(argv[i + 1]);
+    }
+
+    Terrain terrain;
+    GameState state;
+    if (!loadLevel(argv[0], terrain, state)) {
+        cerr << "cannot read level " << argv[0] << endl;
+        return 1;
+    }
+
+    IslandModel<Config> model(islands, seed);
+    typename IslandModel<Config>::Result result = model.run(state, terrain, generations, milliseconds);
+
+    cout << "islands " << islands << " seed " << seed << endl;
+    cout << "generations " << result.generations << " in " << fixed << setprecision(3) << result.seconds << " s" << endl;
+    cout << "best fitness " << setprecision(2) << result.best.fitness << endl;
+    cout << "plan";
+    GameState replay = state;
+    for (int i = 0; i < Config::CHROMOSOME_SIZE; ++i) {
+        int newRotate = max(-90, min(90, replay.rotate + result.best.genes[i].rotate));
+        int newPower = max(0, min(4, replay.power + result.best.genes[i].power));
+        applyCommand(replay, newRotate, newPower);
+        cout << " " << newRotate << "/" << newPower;
+    }
+    cout << endl;
+    return 0;
+}
+
+struct Episode {
+    string level;
+    bool landed;
+    int fuel;
+    int turns;
+    int timeouts; // Turns answered after the CodinGame limit
+    long long generations;
+    long long simulations;
+    double seconds; // Time spent thinking, pondering included
+};
+
+// Referees one game the way CodinGame does: the world moves in doubles, the
+// pilot sees it rounded to integers, and it ends on the first contact with
+// the ground or the map border
+template <class Config>
+Episode playEpisode(const string& path, const string& method, uint64_t seed, double milliseconds, long long generations, double turnaround) {
+    Episode episode = {path, false, 0, 0, 0, 0, 0, 0};
+    Terrain terrain;
+    GameState world;
+    if (!loadLevel(path, terrain, world)) {
+        cerr << "cannot read level " << path << endl;
+        return episode;
+    }
+
+    unique_ptr<Pilot<Config>> pilot(new Pilot<Config>(seed, method));
+#ifdef TELEMETRY
+    pilot->telemetry.open(filesystem::path(path).stem().string() + ".telemetry.bin");
+#endif
+    for (int turn = 0; turn < MAX_TURNS; ++turn) {
+        GameState seen = world;
+        seen.x = round(world.x);
+        seen.y = round(world.y);
+        seen.hSpeed = round(world.hSpeed);
+        seen.vSpeed = round(world.vSpeed);
+
+        auto start = steady_clock::now();
+        Gene command = pilot->decide(seen, terrain, milliseconds, generations);
+        double thinking = duration<double>(steady_clock::now() - start).count();
+        episode.seconds += thinking;
+#ifdef TELEMETRY
+        pilot->report(seen, terrain);
+#endif
+        episode.timeouts += thinking * 1000 > (turn == 0 ? FIRST_TURN_MS : TURN_MS);
+        episode.generations += pilot->generations;
+#ifdef PONDER
+        episode.generations += pilot->pondering;
+#endif
+
+        // Rotation and thrust change by at most 15 degrees and 1 per turn
+        int newRotate = max(world.rotate - 15, min(world.rotate + 15, command.rotate));
+        int newPower = max(world.power - 1, min(world.power + 1, command.power));
+        newPower = min(newPower, world.fuel);
+
+        double x = world.x, y = world.y;
+        applyCommand(world, newRotate, newPower);
+        episode.turns = turn + 1;
+
+        int touchdown = terrain.touchdown(x, y, world.x, world.y);
+        if (touchdown != IN_FLIGHT) {
+            episode.landed = terrain.landed(world, touchdown);
+            break;
+        }
+
+#ifdef PONDER
+        // Let the pilot search ahead while the referee "takes" its turnaround
+        if (turnaround > 0) {
+            applyCommand(seen, command.rotate, command.power);
+            pilot->ponder(seen, terrain);
+            this_thread::sleep_for(duration<double, milli>(turnaround));
+            episode.seconds += turnaround / 1000;
+        }
+#else
+        (void)turnaround;
+#endif
+    }
+#ifdef PONDER
+    // The last turn may have left the ponderer stepping the optimizer
+    pilot->stopPonder();
+    if (pilot->pondered) episode.generations += pilot->pondering;
+#endif
+    episode.fuel = world.fuel;
+    episode.simulations = pilot->optimizer->simulationCount();
+    return episode;
+}
+
+// Plays every level of a file or directory, 'jobs' episodes at a time:
+// Without --ms or --generations the pilot gets the CodinGame time limits.
+// In a PONDER build, --turnaround T makes the referee wait T ms between
+// turns while the pilot ponders.
+//   play <level|dir> [--optimizer ga|sa|cem] [--seed S] [--jobs J] [--ms T | --generations G] [--turnaround T]
+template <class Config>
+int runPlay(int argc, char** argv) {
+    if (argc < 1) {
+        cerr << "usage: play <level|dir> [--optimizer ga|sa|cem] [--seed S] [--jobs J] [--ms T | --generations G]" << endl;
+        return 1;
+    }
+    string method = "ga";
+    uint64_t seed = 1;
+    int jobs = max(1, (int)thread::hardware_concurrency());
+    double milliseconds = 0;
+    long long generations = 0;
+    double turnaround = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i];
+        if (flag == "--optimizer") method = argv[i + 1];
+        else if (flag == "--seed") seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (flag == "--jobs") jobs = atoi(argv[i + 1]);
+        else if (flag == "--ms") milliseconds = atof(argv[i + 1]);
+        else if (flag == "--generations") generations = atoll(argv[i + 1]);
+        else if (flag == "--turnaround") turnaround = atof(argv[i + 1]);
+    }
+
+    vector<string> levels;
+    if (filesystem::is_directory(argv[0])) {
+        for (const auto& entry : filesystem::directory_iterator(argv[0])) {
+            levels.push_back(entry.path().string());
         }
+        sort(levels.begin(), levels.end());
+    } else {
+        levels.push_back(argv[0]);
+    }
+
+    vector<Episode> episodes(levels.size());
+    atomic<int> next(0);
+    vector<thread> workers;
+    for (int j = 0; j < min(jobs, (int)levels.size()); ++j) {
+        workers.emplace_back([&] {
+            for (int i = next++; i < (int)levels.size(); i = next++) {
+                episodes[i] = playEpisode<Config>(levels[i], method, seed, milliseconds, generations, turnaround);
+            }
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+
+    int landed = 0;
+    cout << left << setw(28) << "level" << right << setw(9) << "result" << setw(7) << "fuel" << setw(7) << "turns"
+         << setw(11) << "gens/turn" << setw(12) << "sims/s" << setw(10) << "timeouts" << endl;
+    for (const Episode& episode : episodes) {
+        landed += episode.landed;
+        cout << left << setw(28) << filesystem::path(episode.level).filename().string() << right
+             << setw(9) << (episode.landed ? "landed" : "crashed") << setw(7) << episode.fuel << setw(7) << episode.turns
+             << setw(11) << episode.generations / max(1, episode.turns)
+             << setw(12) << (long long)(episode.simulations / max(episode.seconds, 1e-9))
+             << setw(10) << episode.timeouts << endl;
+    }
+    cout << landed << "/" << episodes.size() << " landed" << endl;
+    return landed == (int)episodes.size() ? 0 : 2;
+}
+
+// Measures the GA loop on one level with a fixed seed and prints JSON:
+//   bench <level> [--seed S] [--runs R]
+template <class Config>
+int runBench(const char* preset, int argc, char** argv) {
+    constexpr int POPULATION_SIZE = Config::POPULATION_SIZE;
+
+    if (argc < 1) {
+        cerr << "usage: bench <level> [--seed S] [--runs R]" << endl;
+        return 1;
+    }
+    uint64_t seed = 1;
+    int runs = 20;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i];
+        if (flag == "--seed") seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (flag == "--runs") runs = atoi(argv[i + 1]);
+    }
+
+    Terrain terrain;
+    GameState state;
+    if (!loadLevel(argv[0], terrain, state)) {
+        cerr << "cannot read level " << argv[0] << endl;
+        return 1;
+    }
 
+    // Whole plans simulated from the root state, scalar and batched
+    unique_ptr<GeneticPopulation<Config>> gp(new GeneticPopulation<Config>(seed));
+    gp->evaluate(0, state, terrain);
+    const int planRounds = 2000;
+    double checksum = 0;
+    auto start = steady_clock::now();
+    for (int round = 0; round < planRounds; ++round) {
         for (int i = 0; i < POPULATION_SIZE; ++i) {
-            gp.population[i].fitness = simulate(gp.population[i], state, surface, surfaceN);
+            checksum += simulate(gp->population[i], state, terrain);
+        }
+    }
+    double scalarRate = planRounds * POPULATION_SIZE / duration<double>(steady_clock::now() - start).count();
+
+    Chromosome<Config>* batch[SIM_LANES];
+    start = steady_clock::now();
+    for (int round = 0; round < planRounds; ++round) {
+        for (int i = 0; i + SIM_LANES <= POPULATION_SIZE; i += SIM_LANES) {
+            for (int l = 0; l < SIM_LANES; ++l) {
+                batch[l] = &gp->population[i + l];
+                batch[l]->dirtyFrom = 0;
+            }
+            simulateBatch(batch, SIM_LANES, state, terrain);
+            checksum += batch[0]->fitness;
+        }
+    }
+    double batchRate = planRounds * (POPULATION_SIZE / SIM_LANES * SIM_LANES) / duration<double>(steady_clock::now() - start).count();
+
+    // Generations that fit in one 99 ms turn, from a fresh population each run
+    vector<long long> generations;
+    perf::profiler().reset();
+    for (int run = 0; run < runs; ++run) {
+        gp.reset(new GeneticPopulation<Config>(seed + run));
+        gp->evaluate(0, state, terrain);
+        long long count = 0;
+        start = steady_clock::now();
+        while (steady_clock::now() - start < milliseconds(99)) {
+            gp->evolve(state, terrain);
+            ++count;
+        }
+        generations.push_back(count);
+    }
+    sort(generations.begin(), generations.end());
+    unsigned long long phaseTicks[PHASES], totalTicks = 0;
+    for (int p = 0; p < PHASES; ++p) {
+        phaseTicks[p] = perf::profiler().total(PHASE_NAMES[p]).cycles;
+        totalTicks += phaseTicks[p];
+    }
+
+    cout << fixed << setprecision(0);
+    cout << "{" << endl;
+    cout << "  \"level\": \"" << filesystem::path(argv[0]).filename().string() << "\"," << endl;
+    cout << "  \"preset\": \"" << preset << "\"," << endl;
+    cout << "  \"seed\": " << seed << "," << endl;
+    cout << "  \"simulate_calls_per_s\": {\"scalar\": " << scalarRate << ", \"batch\": " << batchRate << "}," << endl;
+    cout << "  \"generations_per_99ms\": {\"min\": " << generations.front()
+         << ", \"median\": " << generations[generations.size() / 2]
+         << ", \"max\": " << generations.back() << "}," << endl;
+    cout << setprecision(4) << "  \"phase_share\": {";
+    for (int p = 0; p < PHASES; ++p) {
+        cout << (p ? ", " : "") << "\"" << PHASE_NAMES[p] << "\": " << (double)phaseTicks[p] / max(1ULL, totalTicks);
+    }
+    cout << "}," << endl;
+    cout << setprecision(2) << "  \"plan_checksum\": " << checksum << endl;
+    cout << "}" << endl;
+    return 0;
+}
+
+// Gives every optimizer the same budget on a level's first state and prints
+// the best fitness each one had reached at a few points in time:
+//   race <level> [--seed S] [--ms T]
+template <class Config>
+int runRace(int argc, char** argv) {
+    if (argc < 1) {
+        cerr << "usage: race <level> [--seed S] [--ms T]" << endl;
+        return 1;
+    }
+    uint64_t seed = 1;
+    double milliseconds = TURN_MS;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i];
+        if (flag == "--seed") seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (flag == "--ms") milliseconds = atof(argv[i + 1]);
+    }
+
+    Terrain terrain;
+    GameState state;
+    if (!loadLevel(argv[0], terrain, state)) {
+        cerr << "cannot read level " << argv[0] << endl;
+        return 1;
+    }
+
+    const double SAMPLE_MS[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000};
+    vector<double> samples;
+    for (double sample : SAMPLE_MS) {
+        if (sample < milliseconds) {
+            samples.push_back(sample);
         }
+    }
+    samples.push_back(milliseconds);
+
+    const int methods = sizeof(OPTIMIZER_NAMES) / sizeof(OPTIMIZER_NAMES[0]);
+    vector<vector<double>> best(methods, vector<double>(samples.size()));
+    vector<long long> steps(methods, 0);
+    for (int m = 0; m < methods; ++m) {
+        unique_ptr<Optimizer<Config>> optimizer(createOptimizer<Config>(OPTIMIZER_NAMES[m], seed));
+        auto start = steady_clock::now();
+        optimizer->evaluate(state, terrain);
+        for (size_t k = 0; k < samples.size(); ++k) {
+            while (duration<double, milli>(steady_clock::now() - start).count() < samples[k]) {
+                optimizer->step(state, terrain);
+                ++steps[m];
+            }
+            best[m][k] = optimizer->getBestChromosome().fitness;
+        }
+    }
 
-        auto start = high_resolution_clock::now();
-        while (duration_cast<milliseconds>(high_resolution_clock::now() - start).count() < 99) {
-            gp.evolve(state, surface, surfaceN);
+    cout << fixed << setprecision(1) << setw(8) << "ms";
+    for (const char* name : OPTIMIZER_NAMES) {
+        cout << setw(12) << name;
+    }
+    cout << endl;
+    for (size_t k = 0; k < samples.size(); ++k) {
+        cout << setw(8) << samples[k];
+        for (int m = 0; m < methods; ++m) {
+            cout << setw(12) << best[m][k];
         }
+        cout << endl;
+    }
+    cout << setw(8) << "steps";
+    for (int m = 0; m < methods; ++m) {
+        cout << setw(12) << steps[m];
+    }
+    cout << endl;
+    return 0;
+}
+
+#endif
+
+void printGameState(const GameState& state) {
+    cerr << fixed << setprecision(2); // Print with 2 decimal places
+    cerr << "Calculated GameState:" << endl;
+    cerr << "X: " << state.x << " Y: " << state.y << endl;
+    cerr << "HSpeed: " << state.hSpeed << " VSpeed: " << state.vSpeed << endl;
+    cerr << "Fuel: " << state.fuel << endl;
+    cerr << "Rotate: " << state.rotate << " Power: " << state.power << endl;
+    cerr << "-------------------------" << endl;
+}
+
+template <class Config>
+int runLive(uint64_t seed) {
+    Pilot<Config> pilot(seed);
+#ifdef TELEMETRY
+    pilot.telemetry.open(TELEMETRY_PATH);
+#endif
 
-        Chromosome best = gp.getBestChromosome();
-        int newRotate = max(-90, min(90, state.rotate + best.genes[0].rotate));
-        int newPower = max(0, min(4, state.power + best.genes[0].power));
-        cout << newRotate << " " << newPower << endl;
-        double rad = newRotate * M_PI / 180.0;
-        double hAcc = -newPower * sin(rad);
-        double vAcc = newPower * cos(rad) - GRAVITY;
+    // The clock starts when a turn's first byte arrives, so parsing and, on
+    // the first turn, building the terrain's distance field count against it
+    cin.peek();
+    auto begin = steady_clock::now();
+    Terrain terrain;
+    terrain.read(cin);
 
-        state.x += state.hSpeed + 0.5 * hAcc;
-        state.y += state.vSpeed + 0.5 * vAcc;
-        state.hSpeed += hAcc;
-        state.vSpeed += vAcc;
+    GameState state;
+    while (state.read(cin)) {
+        Gene command = pilot.decide(state, terrain, 0, 0, begin);
+        cout << command.rotate << " " << command.power << endl;
+#ifdef TELEMETRY
+        pilot.report(state, terrain);
+#endif
 
-        state.fuel -= newPower;
-        state.rotate = newRotate;
-        state.power = newPower;
+        applyCommand(state, command.rotate, command.power);
         printGameState(state);
+        perf::profiler().report();
+        perf::profiler().reset();
+#ifdef PONDER
+        cerr << "Pondered " << pilot.pondering << " generations" << endl;
+        pilot.ponder(state, terrain);
+#endif
+        cin.peek();
+        begin = steady_clock::now();
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+// Runs one command of the bot with the parameters of Config
+template <class Config>
+int runPreset(const string& command, const char* preset, int argc, char** argv) {
+#ifdef MODE_LOCAL
+    if (command == "solve") {
+        return runSolve<Config>(argc, argv);
+    }
+    if (command == "play") {
+        return runPlay<Config>(argc, argv);
+    }
+    if (command == "bench") {
+        return runBench<Config>(preset, argc, argv);
+    }
+    if (command == "race") {
+        return runRace<Config>(argc, argv);
+    }
+#else
+    (void)command;
+    (void)preset;
+#endif
+    // Pass a seed as the first argument to make a local run reproducible
+    uint64_t seed = argc > 0 ? strtoull(argv[0], nullptr, 10)
+                             : (uint64_t)steady_clock::now().time_since_epoch().count();
+    return runLive<Config>(seed);
+}
+
+// Parameter presets selectable by name; the first one is the default
+struct Preset {
+    const char* name;
+    int (*run)(const string& command, const char* preset, int argc, char** argv);
+};
+
+//                                           genes  size  elites  tournament  mutation per mille  holds
+const Preset PRESETS[] = {
+    {"default", runPreset<GeneticConfig<100, 50, 10, 5, 20>>},
+    {"large", runPreset<GeneticConfig<100, 100, 20, 5, 20>>},
+    {"short", runPreset<GeneticConfig<60, 40, 8, 4, 25>>},
+    {"long", runPreset<GeneticConfig<150, 50, 10, 5, 15>>},
+    {"holds", runPreset<GeneticConfig<100, 50, 10, 5, 60, 20>>},
+};
+
+const Preset* findPreset(const string& name) {
+    for (const Preset& preset : PRESETS) {
+        if (name == preset.name) {
+            return &preset;
+        }
+    }
+    cerr << "unknown preset " << name << ", using " << PRESETS[0].name << endl;
+    return &PRESETS[0];
+}
+
+#ifdef MODE_LOCAL
+// Local tools: <command> <level> [--preset P] [options]; bench also takes
+// --preset all to sweep every preset in one run
+int runLocal(int argc, char** argv) {
+    string command = argc > 1 ? argv[1] : "";
+    if (command != "solve" && command != "play" && command != "bench" && command != "race") {
+        cerr << "usage: " << argv[0] << " solve|play|bench|race <level> [--preset P] [options]" << endl;
+        return 1;
+    }
+    string name = PRESETS[0].name;
+    for (int i = 3; i + 1 < argc; ++i) {
+        if (string(argv[i]) == "--preset") {
+            name = argv[i + 1];
+        }
+    }
+
+    if (name == "all" && command == "bench") {
+        int status = 0;
+        cout << "[" << endl;
+        for (const Preset& preset : PRESETS) {
+            if (&preset != PRESETS) {
+                cout << "," << endl;
+            }
+            status |= preset.run(command, preset.name, argc - 2, argv + 2);
+        }
+        cout << "]" << endl;
+        return status;
+    }
+    const Preset* preset = findPreset(name);
+    return preset->run(command, preset->name, argc - 2, argv + 2);
+}
+#endif
+
+int main(int argc, char** argv) {
+#ifdef MODE_LOCAL
+    return runLocal(argc, argv);
+#endif
+
+    // Arguments: [seed] [preset]
+    const Preset* preset = findPreset(argc > 2 ? argv[2] : PRESETS[0].name);
+    return preset->run("live", preset->name, min(argc - 1, 1), argv + 1);
+}
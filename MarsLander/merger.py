@@ -0,0 +1,38 @@
+import re
+from pathlib import Path
+
+# Builds the single-file submission: MarsLander.cpp with every
+# #include "..." replaced in place by the file it names. Unlike
+# Ghost-in-the-cell/merger.py nothing is hoisted, so the optimisation
+# pragmas at the top of MarsLander.cpp still come before everything else.
+
+SOURCE_FILE = Path("MarsLander.cpp")
+OUTPUT_FILE = Path("combined.cpp")
+
+LOCAL_INCLUDE = re.compile(r'#include "([^"]+)"')
+
+def inline_file(path, seen):
+    path = path.resolve()
+    if path in seen:
+        return []
+    seen.add(path)
+
+    lines = []
+    for line in path.read_text(encoding="utf-8").splitlines(keepends=True):
+        stripped = line.strip()
+        if stripped == "#pragma once":
+            continue
+        match = LOCAL_INCLUDE.fullmatch(stripped)
+        if match:
+            included = path.parent / match.group(1)
+            lines.append(f"// --- {included.name} ---\n")
+            lines.extend(inline_file(included, seen))
+            lines.append(f"// --- end of {included.name} ---\n")
+            continue
+        lines.append(line)
+    return lines
+
+if __name__ == "__main__":
+    merged = inline_file(SOURCE_FILE, set())
+    OUTPUT_FILE.write_text("".join(merged), encoding="utf-8")
+    print(f"✅ Merged into: {OUTPUT_FILE}")
@@ -0,0 +1,51 @@
+import struct
+import sys
+
+# Converts a telemetry file written by a -DTELEMETRY build of MarsLander.cpp
+# into three CSV files: <prefix>_generations.csv, <prefix>_turns.csv and
+# <prefix>_trajectories.csv.
+
+MAGIC = 0x4C544C4D  # "MLTL"
+RECORD = struct.Struct("<BBHIff")
+
+GENERATION, TURN, TRAJECTORY, DROPPED = range(4)
+
+
+def convert(input_path, prefix):
+    with open(input_path, "rb") as f:
+        magic, version, record_size = struct.unpack("<III", f.read(12))
+        if magic != MAGIC or record_size != RECORD.size:
+            sys.exit(f"{input_path} is not a version {version} telemetry file")
+        data = f.read()
+
+    generations = open(prefix + "_generations.csv", "w")
+    turns = open(prefix + "_turns.csv", "w")
+    trajectories = open(prefix + "_trajectories.csv", "w")
+    generations.write("turn,generation,best,mean\n")
+    turns.write("turn,generations,ms\n")
+    trajectories.write("turn,step,x,y\n")
+
+    dropped = 0
+    for offset in range(0, len(data) - RECORD.size + 1, RECORD.size):
+        kind, _, turn, index, a, b = RECORD.unpack_from(data, offset)
+        if kind == GENERATION:
+            generations.write(f"{turn},{index},{a:.2f},{b:.2f}\n")
+        elif kind == TURN:
+            turns.write(f"{turn},{index},{b:.3f}\n")
+        elif kind == TRAJECTORY:
+            trajectories.write(f"{turn},{index},{a:.2f},{b:.2f}\n")
+        elif kind == DROPPED:
+            dropped += index
+
+    for f in (generations, turns, trajectories):
+        f.close()
+    if dropped:
+        print(f"warning: {dropped} records were dropped by a full ring buffer")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.exit("usage: telemetry_to_csv.py <telemetry.bin> [output prefix]")
+    input_file = sys.argv[1]
+    output_prefix = sys.argv[2] if len(sys.argv) > 2 else input_file.rsplit(".bin", 1)[0]
+    convert(input_file, output_prefix)
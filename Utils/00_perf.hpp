@@ -0,0 +1,534 @@
+#pragma once
+
+// Header-only performance toolkit shared by the C++ bots: rdtsc profiler
+// zones, a deadline timer, seedable RNGs, a bump arena and fixed-capacity
+// containers. Nothing here allocates after start-up.
+//
+// Amalgamation rules (see Ghost-in-the-cell/merger.py and
+// MarsLander/merger.py): this file only uses unconditional <...> includes,
+// never includes other project headers and keeps everything inside
+// namespace perf, so it can be pasted into any bot without clashing with its
+// own names. Build flags are passed with -D on the command line, since
+// Ghost-in-the-cell's merger puts a #define in main.cpp after this file.
+//   -DNO_PROFILE  compiles PERF_ZONE out entirely
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace perf {
+
+// ---------------------------------------------------------------- clocks
+
+using Clock = std::chrono::steady_clock;
+
+inline double millisecondsSince(Clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+// Raw cycle counter. Falls back to steady_clock nanoseconds off x86, where
+// the profiler's calibration then simply finds one tick per nanosecond.
+inline uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+#endif
+}
+
+// ---------------------------------------------------------------- profiler
+
+// Names of every zone, shared by all threads. A zone is registered once per
+// PERF_ZONE call site (and per template instance containing one), so the
+// same name may appear on several rows.
+class ZoneRegistry {
+public:
+    static const int MAX_ZONES = 64;
+
+    ZoneRegistry() : count(0) {}
+
+    int add(const char* name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(count < MAX_ZONES);
+        names[count] = name;
+        return count++;
+    }
+
+    int size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return count;
+    }
+
+    // Only valid for an index below a size() read by the same thread
+    const char* name(int index) const { return names[index]; }
+
+private:
+    std::mutex mutex;
+    const char* names[MAX_ZONES];
+    int count;
+};
+
+inline ZoneRegistry& zoneRegistry() {
+    static ZoneRegistry instance;
+    return instance;
+}
+
+struct ProfileZone {
+    uint64_t cycles;      // Inclusive, children counted
+    uint64_t childCycles; // Spent in zones opened while this one was active
+    uint64_t calls;
+};
+
+// Accumulates cycles per zone for one thread. Zones nest: time spent in an
+// inner zone is also subtracted from the enclosing one, so the report shows
+// both inclusive and self time. Every thread has its own Profiler (see
+// profiler()), so search threads can open zones without any locking.
+class Profiler {
+public:
+    static const int MAX_ZONES = ZoneRegistry::MAX_ZONES;
+
+    Profiler() : zones(), active(-1), startCycles(readCycles()), startTime(Clock::now()) {}
+
+    // Registers a zone and returns its index. PERF_ZONE calls this once per
+    // call site.
+    static int zone(const char* name) {
+        return zoneRegistry().add(name);
+    }
+
+    int enter(int index) {
+        int parent = active;
+        active = index;
+        return parent;
+    }
+
+    void leave(int index, int parent, uint64_t cycles) {
+        ProfileZone& z = zones[index];
+        z.cycles += cycles;
+        ++z.calls;
+        if (parent >= 0) zones[parent].childCycles += cycles;
+        active = parent;
+    }
+
+    // Cycles per millisecond, measured since construction or reset
+    double cyclesPerMs() const {
+        double ms = millisecondsSince(startTime);
+        return ms > 0 ? (readCycles() - startCycles) / ms : 1.0;
+    }
+
+    void reset() {
+        for (ProfileZone& z : zones) {
+            z = ProfileZone{0, 0, 0};
+        }
+        startCycles = readCycles();
+        startTime = Clock::now();
+    }
+
+    // Sum over every zone registered under 'name'
+    ProfileZone total(const char* name) const {
+        ProfileZone sum{0, 0, 0};
+        int count = zoneRegistry().size();
+        for (int i = 0; i < count; ++i) {
+            if (std::strcmp(zoneRegistry().name(i), name) != 0) continue;
+            sum.cycles += zones[i].cycles;
+            sum.childCycles += zones[i].childCycles;
+            sum.calls += zones[i].calls;
+        }
+        return sum;
+    }
+
+    // One row per zone: calls, inclusive and self milliseconds, share of the
+    // wall time since construction or reset, and cycles per call
+    void report(std::FILE* out = stderr) const {
+        double perMs = cyclesPerMs();
+        double wallMs = millisecondsSince(startTime);
+        int count = zoneRegistry().size();
+        std::fprintf(out, "%-24s %10s %10s %10s %6s %12s\n", "zone", "calls", "total ms", "self ms", "%", "cycles/call");
+        for (int i = 0; i < count; ++i) {
+            const ProfileZone& z = zones[i];
+            if (z.calls == 0) continue;
+            double totalMs = z.cycles / perMs;
+            double selfMs = (z.cycles - z.childCycles) / perMs;
+            std::fprintf(out, "%-24s %10llu %10.3f %10.3f %6.1f %12.0f\n", zoneRegistry().name(i),
+                         (unsigned long long)z.calls, totalMs, selfMs, wallMs > 0 ? 100.0 * totalMs / wallMs : 0.0,
+                         (double)z.cycles / z.calls);
+        }
+    }
+
+    const ProfileZone& operator[](int index) const { return zones[index]; }
+
+private:
+    ProfileZone zones[MAX_ZONES];
+    int active;
+    uint64_t startCycles;
+    Clock::time_point startTime;
+};
+
+// The calling thread's profiler
+inline Profiler& profiler() {
+    static thread_local Profiler instance;
+    return instance;
+}
+
+// Times the enclosing scope into one zone of the calling thread's profiler
+class ScopedZone {
+public:
+    explicit ScopedZone(int index) : owner(profiler()), index(index), parent(owner.enter(index)), start(readCycles()) {}
+    ~ScopedZone() { owner.leave(index, parent, readCycles() - start); }
+
+    ScopedZone(const ScopedZone&) = delete;
+    ScopedZone& operator=(const ScopedZone&) = delete;
+
+private:
+    Profiler& owner;
+    int index;
+    int parent;
+    uint64_t start;
+};
+
+#define PERF_CONCAT_INNER(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_INNER(a, b)
+
+#ifdef NO_PROFILE
+#define PERF_ZONE(name) ((void)0)
+#else
+// Profiles the rest of the enclosing scope under 'name', a string that
+// outlives the program's zones (a literal or a static table entry).
+// Costs two rdtsc reads per pass, so keep zones around phases, not around
+// single simulation steps.
+#define PERF_ZONE(name) \
+    static const int PERF_CONCAT(perfZoneId_, __LINE__) = ::perf::Profiler::zone(name); \
+    ::perf::ScopedZone PERF_CONCAT(perfZone_, __LINE__)(PERF_CONCAT(perfZoneId_, __LINE__))
+#endif
+
+// ---------------------------------------------------------------- deadline
+
+// A turn budget. start() takes the moment the turn began (usually when the
+// turn's input starts arriving) so input parsing counts against it.
+// poll() is for search loops: it reads the clock only every 'stride' calls,
+// recalibrating the stride so a check happens about every CHECK_PERIOD_MS,
+// and stops early enough that the iterations until the next check still fit.
+class DeadlineTimer {
+public:
+    static constexpr double CHECK_PERIOD_MS = 0.5;
+    static const int MAX_STRIDE = 256;
+
+    DeadlineTimer() : limitMs(0), stride(1), sinceCheck(0), worstIterationMs(0) {}
+    explicit DeadlineTimer(double milliseconds, Clock::time_point begin = Clock::now()) : DeadlineTimer() {
+        start(milliseconds, begin);
+    }
+
+    void start(double milliseconds, Clock::time_point begin = Clock::now()) {
+        this->begin = begin;
+        limitMs = milliseconds;
+        lastCheck = Clock::now();
+        sinceCheck = 0;
+        worstIterationMs = 0;
+        stride = 1;
+    }
+
+    double elapsedMs() const { return millisecondsSince(begin); }
+    double remainingMs() const { return limitMs - elapsedMs(); }
+    bool expired() const { return elapsedMs() >= limitMs; }
+
+    // Call before each iteration; false once the loop has to stop
+    bool poll() {
+        if (sinceCheck < stride) {
+            ++sinceCheck;
+            return true;
+        }
+        Clock::time_point now = Clock::now();
+        double iterationMs = std::chrono::duration<double, std::milli>(now - lastCheck).count() / sinceCheck;
+        if (iterationMs > worstIterationMs) worstIterationMs = iterationMs;
+        double ideal = iterationMs > 0 ? CHECK_PERIOD_MS / iterationMs : MAX_STRIDE;
+        stride = ideal < 1 ? 1 : ideal > MAX_STRIDE ? MAX_STRIDE : (int)ideal;
+        lastCheck = now;
+        sinceCheck = 1;
+        // Leave room for the next window at the current rate, or for one
+        // iteration as slow as the worst seen, whichever is longer
+        double marginMs = stride * iterationMs > worstIterationMs ? stride * iterationMs : worstIterationMs;
+        return std::chrono::duration<double, std::milli>(now - begin).count() + marginMs < limitMs;
+    }
+
+    double limit() const { return limitMs; }
+    double worstIteration() const { return worstIterationMs; } // Over this turn
+
+private:
+    double limitMs;
+    int stride;
+    int sinceCheck;
+    double worstIterationMs;
+    Clock::time_point begin, lastCheck;
+};
+
+// ---------------------------------------------------------------- random
+
+// Shared helpers for the generators below. Each one also models
+// UniformRandomBitGenerator, so it works with std::shuffle and friends.
+template <class Derived>
+class RandomEngine {
+public:
+    using result_type = uint64_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<uint64_t>::max(); }
+    result_type operator()() { return self().next(); }
+
+    // Uniform in [0, n) without a division (Lemire's multiply-shift)
+    int nextInt(int n) {
+        return (int)(((self().next() >> 32) * (uint64_t)n) >> 32);
+    }
+
+    // Uniform in [lo, hi]
+    int nextRange(int lo, int hi) {
+        return lo + nextInt(hi - lo + 1);
+    }
+
+    // Uniform in [0, 1)
+    double nextDouble() {
+        return (self().next() >> 11) * 0x1.0p-53;
+    }
+
+    float nextFloat() {
+        return (self().next() >> 40) * 0x1.0p-24f;
+    }
+
+    bool nextBool() {
+        return self().next() >> 63;
+    }
+
+    // Standard normal through Box-Muller, one draw per call
+    double nextGaussian() {
+        return std::sqrt(-2.0 * std::log(1.0 - nextDouble())) * std::cos(6.283185307179586 * nextDouble());
+    }
+
+private:
+    Derived& self() { return static_cast<Derived&>(*this); }
+};
+
+inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// One multiply-xorshift round per draw. Mostly used to expand a single seed
+// into the state of the bigger generators.
+class SplitMix64 : public RandomEngine<SplitMix64> {
+public:
+    uint64_t state;
+
+    explicit SplitMix64(uint64_t seed = 0) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+// xoshiro256**: the general-purpose choice, 256 bits of state. MarsLander's
+// search draws from it, so one seed replays one run exactly.
+class Xoshiro256 : public RandomEngine<Xoshiro256> {
+public:
+    uint64_t s[4];
+
+    explicit Xoshiro256(uint64_t seed = 0) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        SplitMix64 expand(seed);
+        for (int i = 0; i < 4; ++i) s[i] = expand.next();
+    }
+
+    uint64_t next() {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+};
+
+// wyrand: a single 64-bit word and one 128-bit multiply per draw. The
+// cheapest of the three when a rollout burns through millions of numbers.
+class WyRand : public RandomEngine<WyRand> {
+public:
+    uint64_t state;
+
+    explicit WyRand(uint64_t seed = 0) : state(seed) {}
+
+    uint64_t next() {
+        state += 0xA0761D6478BD642FULL;
+        __uint128_t m = (__uint128_t)state * (state ^ 0xE7037ED1A0B428DBULL);
+        return (uint64_t)(m >> 64) ^ (uint64_t)m;
+    }
+};
+
+using Rng = Xoshiro256;
+
+// A seed that differs between runs, for when the caller did not pick one
+inline uint64_t entropySeed() {
+    return SplitMix64(readCycles() ^ (uint64_t)Clock::now().time_since_epoch().count()).next();
+}
+
+// ---------------------------------------------------------------- arena
+
+// Hands out memory from one fixed buffer by bumping an offset. Objects are
+// never destroyed individually: rewind to a mark or reset() between turns.
+// Only trivially destructible types may be created, since no destructor
+// ever runs. The buffer is inline, so keep big arenas static or global.
+template <size_t Bytes>
+class BumpArena {
+public:
+    BumpArena() : offset(0), peak(0) {}
+
+    BumpArena(const BumpArena&) = delete;
+    BumpArena& operator=(const BumpArena&) = delete;
+
+    // nullptr when the arena is full
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+        size_t begin = (offset + alignment - 1) & ~(alignment - 1);
+        if (begin + size > Bytes) return nullptr;
+        offset = begin + size;
+        if (offset > peak) peak = offset;
+        return buffer + begin;
+    }
+
+    template <class T, class... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value, "BumpArena never runs destructors");
+        void* p = allocate(sizeof(T), alignof(T));
+        return p ? new (p) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    // Uninitialised storage for 'count' objects
+    template <class T>
+    T* array(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "BumpArena never runs destructors");
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    size_t mark() const { return offset; }
+    void rewind(size_t mark) { offset = mark; }
+    void reset() { offset = 0; }
+
+    size_t used() const { return offset; }
+    size_t highWater() const { return peak; } // Most bytes ever in use at once
+    static constexpr size_t capacity() { return Bytes; }
+
+private:
+    alignas(64) unsigned char buffer[Bytes];
+    size_t offset;
+    size_t peak;
+};
+
+// ---------------------------------------------------------------- containers
+
+// A vector with its storage inline. T must be default constructible: all
+// N elements exist for the container's whole life and pop_back() / clear()
+// only move the size. Capacity is checked with assert.
+template <class T, int N>
+class FixedVector {
+public:
+    FixedVector() : count(0) {}
+
+    void push_back(const T& value) {
+        assert(count < N);
+        items[count++] = value;
+    }
+
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        assert(count < N);
+        return items[count++] = T{std::forward<Args>(args)...};
+    }
+
+    void pop_back() {
+        assert(count > 0);
+        --count;
+    }
+
+    // Removes item i in O(1) by moving the last one into its place
+    void swapRemove(int i) {
+        assert(i < count);
+        items[i] = std::move(items[--count]);
+    }
+
+    void resize(int size) {
+        assert(size <= N);
+        count = size;
+    }
+
+    void clear() { count = 0; }
+
+    T& operator[](int i) { return items[i]; }
+    const T& operator[](int i) const { return items[i]; }
+    T& back() { return items[count - 1]; }
+    const T& back() const { return items[count - 1]; }
+
+    T* begin() { return items; }
+    T* end() { return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+    T* data() { return items; }
+    const T* data() const { return items; }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == N; }
+    static constexpr int capacity() { return N; }
+
+private:
+    T items[N];
+    int count;
+};
+
+// A FIFO ring with its storage inline. N must be a power of two so wrapping
+// is a mask. Same default-constructible rule as FixedVector.
+template <class T, int N>
+class FixedQueue {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "FixedQueue capacity must be a power of two");
+
+public:
+    FixedQueue() : head(0), tail(0) {}
+
+    void push(const T& value) {
+        assert(!full());
+        items[tail++ & (N - 1)] = value;
+    }
+
+    T pop() {
+        assert(!empty());
+        return std::move(items[head++ & (N - 1)]);
+    }
+
+    T& front() { return items[head & (N - 1)]; }
+    const T& front() const { return items[head & (N - 1)]; }
+
+    // i-th element counted from the front
+    T& operator[](int i) { return items[(head + i) & (N - 1)]; }
+    const T& operator[](int i) const { return items[(head + i) & (N - 1)]; }
+
+    void clear() { head = tail = 0; }
+
+    int size() const { return (int)(tail - head); }
+    bool empty() const { return head == tail; }
+    bool full() const { return size() == N; }
+    static constexpr int capacity() { return N; }
+
+private:
+    T items[N];
+    uint32_t head, tail; // Free-running; only the low bits index items
+};
+
+} // namespace perf